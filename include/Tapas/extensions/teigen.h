@@ -18,12 +18,36 @@ template <class T>
 class tarr : public tcompo_v,
 			 public Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic>
 {
+private:
+	tmem * __mem;  /// accounting of the buffer, the one of the array
+
+/// @return the bytes of the buffer, accounted as type **arr** (see tmem)
+std::size_t buffer_bytes() const
+{
+	return static_cast<std::size_t>(this->size()) * sizeof(T);
+}
+
 public:
+Tap_COMPO_ALLOC(compo_tarr)  // allocated by tslab, not by Eigen
+
 tarr(const Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic> & a)
-	: Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic>(a) {}
+	: Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic>(a)
+{
+	__mem = tslab::get_current()->get_mem();
+	__mem->charge(compo_tarr, buffer_bytes(), 0);
+}
 
 tarr(long rows, long cols)
-	: Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic>(rows, cols) {}
+	: Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic>(rows, cols)
+{
+	__mem = tslab::get_current()->get_mem();
+	__mem->charge(compo_tarr, buffer_bytes(), 0);
+}
+
+~tarr()
+{
+	__mem->discharge(compo_tarr, buffer_bytes(), 0); // never resized
+}
 
 virtual tarr * copy()
 {
@@ -281,6 +305,8 @@ array_ops(const class tobj & v, tobj & vre,
 }
 
 public:
+Tap_COMPO_ALLOC(compo_tbarr)
+
 tbarr(const eigbarr & a) : tarr<bool>(a) {}
 
 tbarr(const tarr<bool> & a) : tarr<bool>(a) {}
@@ -416,6 +442,8 @@ void array_ops(const class tobj & v, tobj & vre,
 }
 
 public:
+Tap_COMPO_ALLOC(compo_tdarr)
+
 tdarr(const eigdarr & a) : tarr<double>(a) {}
 
 tdarr(const tarr<double> & a) : tarr<double>(a) {}
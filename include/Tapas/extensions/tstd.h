@@ -8,19 +8,180 @@
 namespace tapas
 {
 
-/// String. Created by single or double quotes.
-class tstr : public tcompo_v, public std::string
+/// @return the hash of the `len` bytes at `s` (never 0), by words of 8 bytes
+inline std::size_t hash_bytes(const char * s, std::size_t len)
+{
+	uint64_t h = len * 0x9E3779B97F4A7C15ULL;
+	uint64_t w;
+
+	for (; len >= 8; s += 8, len -= 8) {
+		std::memcpy(&w, s, 8);
+		h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 32;
+	}
+	if (len > 0) {
+		w = 0;
+		std::memcpy(&w, s, len);
+		h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+	}
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ULL;
+	h ^= h >> 33;
+	std::size_t hash = static_cast<std::size_t>(h);
+
+	return hash == 0 ? 1 : hash;
+}
+
+/** Storage shared by the copies of a value of `code` until one of them is
+ *  changed (see tstr::copy, tlist::copy, tdict::copy). It is accounted as the
+ *  storage of the values, and never referred by objects of Tap.
+ */
+template <tcompo_type code>
+class tshared : public tcompo_v
+{
+public:
+Tap_STORAGE_ALLOC(code)
+
+/// Drop the reference of a copy, releasing `this` with the last one
+void unref()
+{
+	if (ddc_refctr() == 0)
+		release();
+}
+
+std::string tostring_abbr() const
+{
+	return tostring_pointer(get_type(), this);
+}
+
+std::string tostring_full() const
+{
+	return tostring_abbr();
+}
+
+tcompo_v * copy()
+{
+	return this;
+}
+
+const char * get_type() const
+{
+	return "Storage";
+}
+
+long len() const
+{
+	return 0;
+}
+
+tcompo_type get_compo_type_code() const
+{
+	return code;
+}
+
+bool identical(tcompo_v * v) const
+{
+	return v == this;
+}
+
+};
+
+/// Strings shorter than this are copied rather than shared, std::string
+/// keeping them without any allocation
+#define Tap_STR_MINSHARED 16
+
+/// Characters shared by strings (see tstr::copy)
+class tstr_shared : public tshared<compo_tstr>
+{
+public:
+	std::string chars;
+	tmem      * mem;    ///< accounting of the characters
+	std::size_t nbytes; ///< bytes of the characters accounted
+
+tstr_shared(std::string && str, tmem * mem, std::size_t nbytes)
+	: chars(std::move(str)), mem(mem), nbytes(nbytes) {}
+
+~tstr_shared()
+{
+	mem->discharge(compo_tstr, nbytes, 0);
+}
+
+};
+
+/** String. Created by single or double quotes.
+ *  @details A copy shares the characters of a long string until either of
+ *  them is changed (see copy), except with Tap_ATOMIC_REFCTR.
+ */
+class tstr : public tcompo_v
 {
 private:
+	std::string   __chars;        /// characters, if not shared
+	tstr_shared * __shared;       /// characters shared with copies (nullptr if none)
+	mutable std::size_t __hash;   /// hash of the string, 0 until taken (see hash)
+	tmem        * __mem;          /// accounting of the characters, the one of the string
+	std::size_t   __nbytes;       /// bytes of the characters accounted, if not shared
+
+/// @return the bytes allocated for the characters of `str` (none if kept in
+/// `str` itself, see Tap_STR_MINSHARED)
+static std::size_t chars_bytes(const std::string & str)
+{
+	return str.capacity() < Tap_STR_MINSHARED ? 0 : str.capacity() + 1;
+}
+
+/// Account the characters as allocated now, grown or freed (see tmem)
+void recharge()
+{
+	std::size_t nbytes = chars_bytes(__chars);
+
+	if (nbytes > __nbytes)
+		__mem->charge(compo_tstr, nbytes - __nbytes, 0);
+	else if (nbytes < __nbytes)
+		__mem->discharge(compo_tstr, __nbytes - nbytes, 0);
+	__nbytes = nbytes;
+}
+
+/// Copy of the string of `shared`, whose hash is `hash`
+tstr(tstr_shared * shared, std::size_t hash) : __shared(shared), __hash(hash)
+{
+	__mem = tslab::get_current()->get_mem();
+	__nbytes = 0;
+	__shared->add_refctr();
+}
+
+/// @return the characters to change, no longer shared with copies
+std::string & unshare()
+{
+	__hash = 0;
+	if (__shared != nullptr) {
+		tstr_shared * shared = __shared;
+
+		if (shared->get_refctr() == 1) {
+			// the characters are taken with their accounting
+			if (shared->mem != __mem) {
+				__mem->charge(compo_tstr, shared->nbytes, 0);
+				shared->mem->discharge(compo_tstr, shared->nbytes, 0);
+			}
+			__chars.swap(shared->chars);
+			__nbytes = shared->nbytes;
+			shared->nbytes = 0;
+		} else {
+			__chars = shared->chars;
+			recharge();
+		}
+		__shared = nullptr;
+		shared->unref();
+	}
+	return __chars;
+}
 
 void idx_int(long idx, tobj & vre)
 {
 	unsigned long idxu = static_cast<unsigned long>(idx);
 
-	if (idx < 0 || idxu >= length())
+	if (idx < 0 || idxu >= chars().length())
 		twarn(ErrRuntime_IdxOutRange).warn("tlist::idx_int", "");
 
-	vre.set_v(new tstr(substr(idxu, 1)));
+	vre.set_v(new tstr(chars().substr(idxu, 1)));
 }
 
 void idx_pair(tpair * const pair, tobj & idxre)
@@ -42,27 +203,28 @@ void idx_pair(tpair * const pair, tobj & idxre)
 
 	if (uv1 > uv2)
 		twarn(ErrRuntime_InvalidIndex).warn("tlist::idx_iter", "");
-	if (uv2 > length()) // v2 could = length
+	if (uv2 > chars().length()) // v2 could = length
 		twarn(ErrRuntime_IdxOutRange).warn("tlist::idx_iter", "");
 
-	idxre.set_v(new tstr(this->substr(uv1, uv2 - uv1)));
+	idxre.set_v(new tstr(chars().substr(uv1, uv2 - uv1)));
 }
 
 void iset_int(const long idx, const tstr * const str)
 {
 	unsigned long idxu = static_cast<unsigned long>(idx);
 
-	if (idx < 0 || idxu >= length())
+	if (idx < 0 || idxu >= chars().length())
 		twarn(ErrRuntime_IdxOutRange).warn("tstr::iset_int", "idx out of scope");
-	if (str->length() != 1)
+	if (str->chars().length() != 1)
 		twarn(ErrRuntime_LenInconsis).warn("tstr::iset_int", "len inconsistency");
 
-	this->replace(idxu, 1, *str);
+	unshare().replace(idxu, 1, str->chars());
+	recharge();
 }
 
 void iset_pair(tpair * const pair, const tstr * const str)
 {
-	uint_size len = str->length();
+	uint_size len = str->chars().length();
 	tobj && first = pair->get_first();
 	tobj && second = pair->get_second();
 	long v1 = first.get_v_tint();
@@ -74,36 +236,98 @@ void iset_pair(tpair * const pair, const tstr * const str)
 	unsigned long uv1 = static_cast<unsigned long>(v1);
 	unsigned long uv2 = static_cast<unsigned long>(v2);
 
-	if (uv1 > length() || uv2 > length())
+	if (uv1 > chars().length() || uv2 > chars().length())
 		twarn(ErrRuntime_IdxOutRange).warn("tstr::iset_pair", "");
 	if (uv1 > uv2)
 		twarn(ErrRuntime_InvalidIndex).warn("tstr::iset_pair", "");
 	if (uv2 - uv1 != len)
 		twarn(ErrRuntime_LenInconsis).warn("tstr::iset_pair", "");
 
-	replace(uv1, len, *str);
+	unshare().replace(uv1, len, str->chars());
+	recharge();
 }
 
 public:
-tstr(const char * str) : std::string(str) {}
+Tap_COMPO_ALLOC(compo_tstr)
+
+tstr(const char * str) : __chars(str), __shared(nullptr), __hash(0)
+{
+	__mem = tslab::get_current()->get_mem();
+	__nbytes = 0;
+	recharge();
+}
+
+tstr(const std::string & str) : __chars(str), __shared(nullptr), __hash(0)
+{
+	__mem = tslab::get_current()->get_mem();
+	__nbytes = 0;
+	recharge();
+}
 
-tstr(std::string str) : std::string(str) {}
+tstr(std::string && str) : __chars(std::move(str)), __shared(nullptr), __hash(0)
+{
+	__mem = tslab::get_current()->get_mem();
+	__nbytes = 0;
+	recharge();
+}
 
-~tstr() {}
+tstr(const tstr &) = delete;
+
+~tstr()
+{
+	if (__shared != nullptr)
+		__shared->unref();
+	__mem->discharge(compo_tstr, __nbytes, 0);
+}
+
+/// @return the characters
+const std::string & chars() const
+{
+	return __shared == nullptr ? __chars : __shared->chars;
+}
 
 std::string tostring_abbr() const
 {
-	return *this;
+	return chars();
 }
 
 std::string tostring_full() const
 {
-	return *this;
+	return chars();
 }
 
+/// @return a copy, sharing the characters if the string is long, until
+/// either of them is changed. With Tap_ATOMIC_REFCTR the string may be read
+/// by other threads meanwhile: the characters are copied, not moved to be
+/// shared
 tstr * copy()
 {
-	return new tstr(c_str());
+#ifdef Tap_ATOMIC_REFCTR
+	return new tstr(chars());
+#else
+	if (__shared == nullptr && __chars.size() < Tap_STR_MINSHARED)
+		return new tstr(__chars);
+	if (__shared == nullptr) {
+		__shared = new tstr_shared(std::move(__chars), __mem, __nbytes);
+		__shared->add_refctr();
+		__chars.clear();
+		__nbytes = 0;
+	}
+	return new tstr(__shared, __hash);
+#endif
+}
+
+/// @return the hash of the string, taken once until it is changed (each
+/// time with Tap_ATOMIC_REFCTR, not to write a string read by other threads)
+std::size_t hash() const
+{
+#ifdef Tap_ATOMIC_REFCTR
+	return hash_bytes(chars().data(), chars().size());
+#else
+	if (__hash == 0)
+		__hash = hash_bytes(chars().data(), chars().size());
+	return __hash;
+#endif
 }
 
 const char * get_type() const
@@ -168,7 +392,7 @@ void iset(const tobj * params, uint_size_stk nparams, const tobj & v)
 
 long len() const
 {
-	return static_cast<long>(length());
+	return static_cast<long>(chars().length());
 }
 
 bool identical(tcompo_v * v) const
@@ -176,78 +400,86 @@ bool identical(tcompo_v * v) const
 	if (v->get_compo_type_code() != compo_tstr)
 		return false;
 	tstr * str = reinterpret_cast<tstr *>(v);
-	return str->compare(*this) == 0;
+	return str->chars().compare(chars()) == 0;
 }
 
 void set_append(const tobj * ele)
 {
+	std::string & chars = unshare();
+
 	switch (ele->get_type()) {
 	case tnil:
 		break;
 	case tbool:
 		switch (ele->get_v_tbool()) {
 		case 0:
-			this->append("false");
+			chars.append("false");
 			break;
 		case 1:
-			this->append("true");
+			chars.append("true");
 			break;
 		}
 		break;
 	case tint:
-		this->append(std::to_string(ele->get_v_tint()));
+		chars.append(std::to_string(ele->get_v_tint()));
 		break;
 	case tdouble:
-		this->append(std::to_string(ele->get_v_tdouble()));
+		chars.append(std::to_string(ele->get_v_tdouble()));
 		break;
 	case tcompo:
-		this->append(ele->get_v_tcompo()->tostring_abbr());
+		chars.append(ele->get_v_tcompo()->tostring_abbr());
 		break;
 	}
+	recharge();
 }
 
 void set_insert(const tobj * ele, const long loc)
 {
-	if (loc < 0 || static_cast<unsigned long>(loc) > size())
+	if (loc < 0 || static_cast<unsigned long>(loc) > chars().size())
 		twarn(ErrRuntime_IdxOutRange).warn("tstr::set_insert", "");
 
+	std::string & chars = unshare();
+
 	switch (ele->get_type()) {
 	case tnil:
 		break;
 	case tbool:
 		switch (ele->get_v_tbool()) {
 		case 0:
-			this->insert(loc, "false");
+			chars.insert(loc, "false");
 			break;
 		case 1:
-			this->insert(loc, "true");
+			chars.insert(loc, "true");
 			break;
 		}
 		break;
 	case tint:
-		this->insert(loc, std::to_string(ele->get_v_tint()));
+		chars.insert(loc, std::to_string(ele->get_v_tint()));
 		break;
 	case tdouble:
-		this->insert(loc, std::to_string(ele->get_v_tdouble()));
+		chars.insert(loc, std::to_string(ele->get_v_tdouble()));
 		break;
 	case tcompo:
-		this->insert(loc, ele->get_v_tcompo()->tostring_abbr());
+		chars.insert(loc, ele->get_v_tcompo()->tostring_abbr());
 		break;
 	}
+	recharge();
 }
 
 void set_pop()
 {
-	if (size() == 0)
+	if (chars().size() == 0)
 		twarn(ErrRuntime_RefEmptySet).warn("tstr::set_pop", "");
-	this->erase(size()-1);
+	std::string & chars = unshare();
+
+	chars.erase(chars.size() - 1);
 }
 
 void set_delete(const long loc)
 {
-	if (loc < 0 || static_cast<unsigned long>(loc) >= size())
+	if (loc < 0 || static_cast<unsigned long>(loc) >= chars().size())
 		twarn(ErrRuntime_IdxOutRange).warn("tstr::set_delete", "");
-	this->erase(loc, 1);
+	unshare().erase(loc, 1);
 }
 
 void set_delete(const tobj * key)
@@ -267,8 +499,8 @@ void set_delete(const tobj * key)
 			while (iter->next()) {
 				long idx =  iter->get_locidx();
 
-				if (idx - ndeleted < size()) {
-					this->erase(idx - ndeleted, 1);
+				if (idx - ndeleted < chars().size()) {
+					unshare().erase(idx - ndeleted, 1);
 					ndeleted++;
 				}
 			}
@@ -285,27 +517,28 @@ void set_delete(const tobj & start, const tobj & to)
 
 	if (i_start < 0 || i_to < 0)
 		twarn(ErrRuntime_IdxOutRange).warn("tstr::set_delete", "");
-	if (i_start > i_to || static_cast<unsigned long>(i_to) > size())
+	if (i_start > i_to || static_cast<unsigned long>(i_to) > chars().size())
 		twarn(ErrRuntime_IdxOutRange).warn("tstr::set_delete", "");
-	this->erase(i_start, i_to - i_start);
+	unshare().erase(i_start, i_to - i_start);
 }
 
 bool to_bool()
 {
-	if (0 == this->compare("true")) return true;
-	if (0 == this->compare("false")) return false;
-	twarn(ErrRuntime_StringEval).warn("tstr::to_bool", this->c_str());
+	if (0 == chars().compare("true")) return true;
+	if (0 == chars().compare("false")) return false;
+	twarn(ErrRuntime_StringEval).warn("tstr::to_bool", chars().c_str());
 	return false;
 }
 
 long to_int()
 {
+	const std::string & chars = this->chars();
 	long it;
 
-	if (std::string::npos == this->find('.')
-	&& std::string::npos == this->find('e')
-	&& std::string::npos == this->find('E')
-	&& sscanf(this->c_str(), "%li", &it) == 1)
+	if (std::string::npos == chars.find('.')
+	&& std::string::npos == chars.find('e')
+	&& std::string::npos == chars.find('E')
+	&& sscanf(chars.c_str(), "%li", &it) == 1)
 		return it;
 	twarn(ErrRuntime_StringEval).warn("tstr::to_int", "");
 	return 0;
@@ -315,7 +548,7 @@ double to_double()
 {
 	double dt;
 
-	if (sscanf(this->c_str(), "%lf", &dt) == 1)
+	if (sscanf(chars().c_str(), "%lf", &dt) == 1)
 		return dt;
 	twarn(ErrRuntime_StringEval).warn("tstr::to_double", "");
 	return 0.0;
@@ -323,24 +556,138 @@ double to_double()
 
 };
 
-/// List. Created by `[...]`
-class tlist : public tcompo_v, public std::vector<tobj>
+/// Elements shared by lists (see tlist::copy)
+class tlist_shared : public tshared<compo_tlist>
+{
+public:
+	std::vector<tobj> elems;
+	tmem      * mem;    ///< accounting of the elements
+	std::size_t nbytes; ///< bytes of the elements accounted
+
+tlist_shared(std::vector<tobj> && v, tmem * mem, std::size_t nbytes)
+	: elems(std::move(v)), mem(mem), nbytes(nbytes)
+{
+	gc_track();
+}
+
+~tlist_shared()
+{
+	for (auto iter = elems.begin(); iter != elems.end(); iter++)
+		iter->ddc_ref_clear();
+	mem->discharge(compo_tlist, nbytes, 0);
+}
+
+/// Visit the elements (see tgc)
+void gc_traverse(tgc_visitf f, void * arg)
+{
+	for (auto iter = elems.begin(); iter != elems.end(); iter++)
+		tgc::visit(*iter, f, arg);
+}
+
+/// Drop the elements (see tgc)
+void gc_clear()
+{
+	for (auto iter = elems.begin(); iter != elems.end(); iter++)
+		iter->ddc_ref_clear();
+	elems.clear();
+}
+
+};
+
+/** List. Created by `[...]`
+ *  @details A copy shares the elements of the list until either of them is
+ *  changed (see copy).
+ */
+class tlist : public tcompo_v
 {
 private:
+	std::vector<tobj> __elems;  /// elements, if not shared
+	tlist_shared    * __shared = nullptr; /// elements shared with copies (nullptr if none)
 	long   __idxi = 0;
 	ttypes __first_ele_type = tnil;
+	tmem      * __mem = tslab::get_current()->get_mem(); /// accounting of the elements, the one of the list
+	std::size_t __nbytes = 0;   /// bytes of the elements accounted, if not shared
+
+/// Account the elements as `cap` allocated, before growing them (see tmem)
+void charge_elems(std::size_t cap)
+{
+	std::size_t nbytes = cap * sizeof(tobj);
+
+	if (nbytes > __nbytes)
+		__mem->charge(compo_tlist, nbytes - __nbytes, 0);
+	else if (nbytes < __nbytes)
+		__mem->discharge(compo_tlist, __nbytes - nbytes, 0);
+	__nbytes = nbytes;
+}
+
+/// Grow the elements for `n` at least, doubling them as std::vector does
+Tap_NOINLINE void reserve(std::size_t n)
+{
+	std::size_t cap = std::max(n, 2 * __elems.capacity());
+
+	charge_elems(cap);
+	__elems.reserve(cap);
+}
+
+/// Copy of the list of `shared`, whose first element is of `type`
+tlist(tlist_shared * shared, ttypes type) : __shared(shared), __first_ele_type(type)
+{
+	gc_track();
+	__shared->add_refctr();
+}
+
+/// @return the elements to change, no longer shared with copies
+std::vector<tobj> & unshare()
+{
+	if (__shared != nullptr) {
+		tlist_shared * shared = __shared;
+
+		if (shared->get_refctr() == 1) {
+			// the elements are taken with their accounting
+			if (shared->mem != __mem) {
+				__mem->charge(compo_tlist, shared->nbytes, 0);
+				shared->mem->discharge(compo_tlist, shared->nbytes, 0);
+			}
+			__elems.swap(shared->elems);
+			__nbytes = shared->nbytes;
+			shared->nbytes = 0;
+		} else {
+			charge_elems(shared->elems.size());
+			__elems.reserve(shared->elems.size());
+			__elems.assign(shared->elems.cbegin(), shared->elems.cend());
+			for (auto iter = __elems.cbegin(); iter != __elems.cend(); iter++)
+				if (iter->get_type() == tcompo)
+					iter->get_v_tcompo()->add_refctr();
+		}
+		__shared = nullptr;
+		shared->unref();
+	}
+	return __elems;
+}
+
+/// @return the elements to change, no longer shared, with room for `n` more
+std::vector<tobj> & unshare(std::size_t n)
+{
+	std::vector<tobj> & elems = unshare();
+
+	if (elems.size() + n > elems.capacity())
+		reserve(elems.size() + n);
+	return elems;
+}
 
 void idx_int(const long idxi, tobj & idxre)
 {
+	const std::vector<tobj> & elems = this->elems();
 	unsigned long idxu = static_cast<unsigned long>(idxi);
 
-	if (idxi < 0 || idxu >= size())
+	if (idxi < 0 || idxu >= elems.size())
 		twarn(ErrRuntime_IdxOutRange).warn("tlist::idx_int", "");
-	idxre = at(idxu);
+	idxre = elems[idxu];
 }
 
 void idx_pair(tpair * const pair, tobj & idxre)
 {
+	const std::vector<tobj> & elems = this->elems();
 	std::vector<tobj> sublst;
 	tobj && first  = pair->get_first();
 	tobj && second = pair->get_second();
@@ -357,12 +704,12 @@ void idx_pair(tpair * const pair, tobj & idxre)
 	unsigned long uv1 = static_cast<unsigned long>(v1);
 	unsigned long uv2 = static_cast<unsigned long>(v2);
 
-	if (uv1 > size() || uv2 > size())
+	if (uv1 > elems.size() || uv2 > elems.size())
 		twarn(ErrRuntime_IdxOutRange).warn("tlist::idx_pair", "");
 	if (uv1 > uv2)
 		twarn(ErrRuntime_InvalidIndex).warn("tlist::idx_pair", "");
 	for (unsigned long ui = uv1; ui < uv2; ui++)
-		sublst.push_back(at(ui));
+		sublst.push_back(elems[ui]);
 
 	idxre.set_v(new tlist(sublst)); // for each ele, refctr ++
 }
@@ -371,11 +718,12 @@ void iset_int(const long idx, const tobj & v)
 {
 	unsigned long idxu = static_cast<unsigned long>(idx);
 
-	if (idx < 0 || idxu >= size())
+	if (idx < 0 || idxu >= elems().size())
 		twarn(ErrRuntime_IdxOutRange).warn("tlist::idx_int", "");
+	tobj & ele = unshare()[idxu];
 
-	at(idxu).ddc_ref_clear();
-	at(idxu) = v;
+	ele.ddc_ref_clear();
+	ele = v;
 
 	if (v.get_type() == tcompo)
 		v.get_v_tcompo()->add_refctr();
@@ -400,49 +748,107 @@ void iset_pair(tpair * iter, const tlist * list)
 
 	if (uv1 > uv2)
 		twarn(ErrRuntime_InvalidIndex).warn("tlist::iset_pair", "");
-	if (uv2 - uv1 != list->size())
+	if (uv2 - uv1 != list->elems().size())
 		twarn(ErrRuntime_LenInconsis).warn("tlist::iset_pair", "");
-	if (uv2 > size()) // v2 could = size
+	if (uv2 > elems().size()) // v2 could = size
 		twarn(ErrRuntime_IdxOutRange).warn("tlist::iset_pair", "");
 
-	for (unsigned long ui = uv1; ui < uv2; ui++) {
-		at(ui).ddc_ref_clear();
-		at(ui) = list->at(li);
+	// taken before unsharing, `list` being `this` or sharing its elements
+	// maybe, and referred once unshared (beyond the memory limit maybe)
+	std::vector<tobj> from(list->elems());
+	std::vector<tobj> & elems = unshare();
+
+	for (auto iter = from.cbegin(); iter != from.cend(); iter++)
+		if (iter->get_type() == tcompo)
+			iter->get_v_tcompo()->add_refctr();
 
-		if (list->at(li).get_type() == tcompo)
-			list->at(li).get_v_tcompo()->add_refctr();
+	for (unsigned long ui = uv1; ui < uv2; ui++) {
+		elems[ui].ddc_ref_clear();
+		elems[ui] = from[li];
 		li++;
 	}
 }
 
 void update_first_ele_type()
 {
-	if (size() > 0)
-		__first_ele_type = at(0).get_type();
-	if (size() == 0)
+	if (__elems.size() > 0)
+		__first_ele_type = __elems[0].get_type();
+	if (__elems.size() == 0)
 		__first_ele_type = tnil;
 }
 
 
 public:
-tlist() {}
+Tap_COMPO_ALLOC(compo_tlist)
+
+tlist()
+{
+	gc_track();
+}
 
 tlist(const std::vector<tobj> & params)
 {
+	gc_track();
 	for (auto iter = params.cbegin(); iter != params.cend(); iter++)
 		set_append(*iter);
 }
 
 tlist(tobj * const params, uint_size_stk len)
 {
+	gc_track();
 	for (uint_size_stk i = 0; i < len; i++)
 		set_append(params + i);
 }
 
+tlist(const tlist &) = delete;
+
 ~tlist()
 {
-	for (auto iter = begin(); iter != end(); iter++)
+	if (__shared != nullptr)
+		__shared->unref();
+	for (auto iter = __elems.begin(); iter != __elems.end(); iter++)
 		iter->ddc_ref_clear();
+	__mem->discharge(compo_tlist, __nbytes, 0);
+}
+
+/// @return the elements
+const std::vector<tobj> & elems() const
+{
+	return __shared == nullptr ? __elems : __shared->elems;
+}
+
+/// @return the first element
+std::vector<tobj>::const_iterator begin() const
+{
+	return elems().cbegin();
+}
+
+/// @return the end of the elements
+std::vector<tobj>::const_iterator end() const
+{
+	return elems().cend();
+}
+
+/// Visit the elements, or the ones shared (see tgc)
+void gc_traverse(tgc_visitf f, void * arg)
+{
+	if (__shared != nullptr)
+		f(__shared, arg);
+	for (auto iter = __elems.begin(); iter != __elems.end(); iter++)
+		tgc::visit(*iter, f, arg);
+}
+
+/// Drop the elements, or the ones shared (see tgc)
+void gc_clear()
+{
+	if (__shared != nullptr) {
+		__shared->unref();
+		__shared = nullptr;
+	}
+	for (auto iter = __elems.begin(); iter != __elems.end(); iter++)
+		iter->ddc_ref_clear();
+	__elems.clear();
+	update_first_ele_type();
 }
 
 std::string tostring_abbr() const
@@ -452,32 +858,30 @@ std::string tostring_abbr() const
 
 std::string tostring_full() const
 {
+	const std::vector<tobj> & elems = this->elems();
 	std::string is;
-	std::vector<tobj>::const_iterator iter = cbegin();
+	std::vector<tobj>::const_iterator iter = elems.cbegin();
 	is += "[";
 
-	for (; iter != cend(); iter++) {
+	for (; iter != elems.cend(); iter++) {
 		tobj v = *iter;
 		is += v.tostring_abbr();
-		if (iter != cend() - 1) is += ", ";
+		if (iter != elems.cend() - 1) is += ", ";
 	}
 	is += "]";
 	return is;
 }
 
+/// @return a copy, sharing the elements until either of them is changed
 tlist * copy()
 {
-	tlist * list = new tlist();
-
-	for (auto iter = cbegin(); iter != cend(); iter++) {
-		if (iter->get_type() == tnil)
-			twarn(ErrRuntime_AssignNil).warn("tlist::copy", "");
-		if (iter->get_type() == tcompo)
-			iter->get_v_tcompo()->add_refctr();
-		list->push_back(*iter);
+	if (__shared == nullptr) {
+		__shared = new tlist_shared(std::move(__elems), __mem, __nbytes);
+		__shared->add_refctr();
+		__elems.clear();
+		__nbytes = 0;
 	}
-	list->update_first_ele_type();
-	return list;
+	return new tlist(__shared, __first_ele_type);
 }
 
 ttypes get_first_ele_type()
@@ -497,7 +901,7 @@ const char * get_type() const
 
 long len() const
 {
-	return static_cast<long>(size());
+	return static_cast<long>(elems().size());
 }
 
 void idx(const tobj * params, uint_size_stk nparams, tobj & idxre)
@@ -546,12 +950,14 @@ void iset(const tobj * params, uint_size_stk nparams, const tobj & v)
 
 void get_v_at_loc(tobj & vre)
 {
-	if (size() == 0) {
+	const std::vector<tobj> & elems = this->elems();
+
+	if (elems.size() == 0) {
 		vre.set_nil();
 		return;
 	}
 
-	auto loc = cbegin() + (__idxi > 1 ? __idxi - 1 : 0);
+	auto loc = elems.cbegin() + (__idxi > 1 ? __idxi - 1 : 0);
 	ttypes type = loc->get_type();
 
 	switch (type) {
@@ -576,7 +982,7 @@ bool next()
 	__idxi++;
 	uint32_t idxu = static_cast<uint32_t>(__idxi);
 
-	if (idxu <= size())
+	if (idxu <= elems().size())
 		return 1;
 	else {
 		iter_restore();
@@ -600,9 +1006,11 @@ void set_append(const tobj * ele)
 {
 	if (ele->get_type() == tnil)
 		twarn(ErrRuntime_AssignNil).warn("tlist::append", "");
+	std::vector<tobj> & elems = unshare(1); // beyond the memory limit maybe
+
 	if (ele->get_type() == tcompo)
 		ele->get_v_tcompo()->add_refctr();
-	push_back(*ele);
+	elems.push_back(*ele);
 	update_first_ele_type();
 }
 
@@ -610,32 +1018,37 @@ void set_append(const tobj & ele)
 {
 	if (ele.get_type() == tnil)
 		twarn(ErrRuntime_AssignNil).warn("tlist::append", "");
+	std::vector<tobj> & elems = unshare(1); // beyond the memory limit maybe
+
 	if (ele.get_type() == tcompo)
 		ele.get_v_tcompo()->add_refctr();
-	push_back(ele);
+	elems.push_back(ele);
 	update_first_ele_type();
 }
 
 void set_insert(const tobj * ele, const long loc)
 {
-	if (loc < 0 || static_cast<unsigned long>(loc) > size())
+	if (loc < 0 || static_cast<unsigned long>(loc) > elems().size())
 		twarn(ErrRuntime_IdxOutRange).warn("tlist::append", "");
 	if (ele->get_type() == tnil)
 		twarn(ErrRuntime_AssignNil).warn("tlist::append", "");
+	std::vector<tobj> & elems = unshare(1); // beyond the memory limit maybe
+
 	if (ele->get_type() == tcompo)
 		ele->get_v_tcompo()->add_refctr();
-
-	insert(begin() + loc, *ele);
+	elems.insert(elems.begin() + loc, *ele);
 	update_first_ele_type();
 }
 
 void set_pop()
 {
-	if (size() == 0)
+	if (elems().size() == 0)
 		twarn(ErrRuntime_RefEmptySet).warn("tlist::set_pop", "");
-	tobj v = back();
+	std::vector<tobj> & elems = unshare();
+	tobj v = elems.back();
+
+	elems.pop_back();
 	v.ddc_ref_clear();
-	pop_back();
 	update_first_ele_type();
 }
 
@@ -646,12 +1059,14 @@ void set_delete(const tobj * key)
 
 	long loc = key->get_v_tint();
 
-	if (loc < 0 || static_cast<unsigned long>(loc) >= size())
+	if (loc < 0 || static_cast<unsigned long>(loc) >= elems().size())
 		twarn(ErrRuntime_IdxOutRange).warn("tlist::set_delete", "");
 
-	tobj v = at(loc);
+	std::vector<tobj> & elems = unshare();
+	tobj v = elems[loc];
+
+	elems.erase(elems.begin() + loc);
 	v.ddc_ref_clear();
-	erase(begin() + loc);
 	update_first_ele_type();
 }
 
@@ -675,18 +1090,408 @@ bool identical(tcompo_v * v) const
 
 };
 
-/// Dict. Created by `{key:value, ...}`
-class tdict : public tcompo_v, public std::unordered_map<std::string, tobj>
+class tdict;
+
+/** Lookup of a constant key in a dict or a record, kept by a bycode
+ *  @details See tdict::find_cached and trecord::find_cached
+ */
+struct tkeycache
 {
+	uint_size_cst name;    ///< location of the key in the constant strings
+	tdict       * dict;    ///< dict of the last lookup (nullptr: record)
+	uint64_t      version; ///< version of the dict (or shape) at the last lookup
+	tobj        * v;       ///< value of the key in the dict (nullptr if absent)
+	uint_size_obj offset;  ///< offset of the key in the shape
+};
+
+/// Control bytes of the slots of a dict: 7 bits of the hash of a key if full
+#define Tap_DICT_EMPTY    0x80
+#define Tap_DICT_DELETED  0xFE
+/// Slots of a dict at least, then doubled when 7/8 of them are taken
+#define Tap_DICT_MINSLOTS 8
+
+/// Entry of a dict: a key, its value and the hash of the key (see hash_bytes)
+struct tdict_entry
+{
+	std::string first;  ///< key
+	tobj        second; ///< value
+	std::size_t hash;   ///< hash of the key
+};
+
+/// Table shared by dicts (see tdict::copy)
+class tdict_shared : public tshared<compo_tdict>
+{
+public:
+	uint8_t     * ctrl;   ///< control bytes of the slots
+	tdict_entry * slots;  ///< slots of the entries
+	uint32_t      nslots; ///< number of slots (0 once cleared)
+	tmem        * mem;    ///< accounting of the table
+
+/// @return the bytes of a table of `nslots` slots, accounted as type **dict** (see tmem)
+static std::size_t table_bytes(uint32_t nslots)
+{
+	return nslots * (sizeof(tdict_entry) + 1);
+}
+
+tdict_shared(uint8_t * ctrl, tdict_entry * slots, uint32_t nslots, tmem * mem)
+	: ctrl(ctrl), slots(slots), nslots(nslots), mem(mem)
+{
+	gc_track();
+}
+
+~tdict_shared()
+{
+	gc_clear();
+}
+
+/// Visit the values (see tgc)
+void gc_traverse(tgc_visitf f, void * arg)
+{
+	for (uint32_t i = 0; i < nslots; i++)
+		if (!(ctrl[i] & Tap_DICT_EMPTY))
+			tgc::visit(slots[i].second, f, arg);
+}
+
+/// Drop the values, then free the table (see tgc)
+void gc_clear()
+{
+	if (nslots == 0)
+		return;
+	for (uint32_t i = 0; i < nslots; i++)
+		if (!(ctrl[i] & Tap_DICT_EMPTY))
+			slots[i].second.ddc_ref_clear();
+	mem->discharge(compo_tdict, table_bytes(nslots), 0);
+	delete [] ctrl;
+	delete [] slots;
+	nslots = 0;
+}
+
+};
+
+/** Dict. Created by `{key:value, ...}`
+ *  @details The entries are kept in a flat table of open addressing, probed
+ *  linearly from the slot of the hash of a key. A control byte by slot tells
+ *  whether it is empty, deleted or full, with 7 bits of the hash of its key,
+ *  so that a lookup compares the keys of few slots. The hashes of the keys
+ *  are kept, and the table is rebuilt without hashing the keys again.
+ *  A copy shares the table until either of them is changed (see copy): the
+ *  table is then referred by both, with the storage keeping it.
+ */
+class tdict : public tcompo_v
+{
+private:
+	uint8_t     * __ctrl;    /// control bytes of the slots
+	tdict_entry * __slots;   /// slots of the entries (nullptr if none)
+	uint32_t      __nslots;  /// number of slots, a power of 2 (0 if none)
+	uint32_t      __size;    /// number of entries
+	uint32_t      __nfree;   /// empty slots to fill before rebuilding the table
+	uint64_t      __version; /// changed whenever a key is added or deleted, or the table rebuilt
+	tmem        * __mem;     /// accounting of the table, the one of the dictionary
+	tdict_shared * __shared; /// storage of the table shared with copies (nullptr if none)
+
+/// @return the entries of `nslots` slots at most
+static uint32_t max_load(uint32_t nslots)
+{
+	return nslots - nslots / 8;
+}
+
+/// @return the bytes of a table of `nslots` slots (see tdict_shared)
+static std::size_t table_bytes(uint32_t nslots)
+{
+	return tdict_shared::table_bytes(nslots);
+}
+
+/// Own the table again, or a copy of it if still shared, before changing it
+Tap_NOINLINE void unshare()
+{
+	tdict_shared * shared = __shared;
+
+	if (shared->get_refctr() > 1) {
+		__mem->charge(compo_tdict, table_bytes(__nslots), 0);
+		uint8_t     * ctrl = new uint8_t[__nslots];
+		tdict_entry * slots = new tdict_entry[__nslots];
+
+		std::memcpy(ctrl, __ctrl, __nslots);
+		for (uint32_t i = 0; i < __nslots; i++) {
+			if (ctrl[i] & Tap_DICT_EMPTY)
+				continue;
+			slots[i] = __slots[i];
+			if (slots[i].second.get_type() == tcompo)
+				slots[i].second.get_v_tcompo()->add_refctr();
+		}
+		__ctrl = ctrl;
+		__slots = slots;
+	} else {
+		if (shared->mem != __mem) {
+			__mem->charge(compo_tdict, table_bytes(__nslots), 0);
+			shared->mem->discharge(compo_tdict, table_bytes(__nslots), 0);
+		}
+		shared->nslots = 0;
+	}
+	__shared = nullptr;
+	__version = new_version();
+	shared->unref();
+}
+
+/// Allocate an empty table of `nslots` slots
+void new_table(uint32_t nslots)
+{
+	__mem->charge(compo_tdict, table_bytes(nslots), 0);
+	__ctrl = new uint8_t[nslots];
+	__slots = new tdict_entry[nslots];
+	__nslots = nslots;
+	std::memset(__ctrl, Tap_DICT_EMPTY, nslots);
+}
+
+/// Free the table, whose values are no longer referred
+void free_table()
+{
+	if (__slots == nullptr)
+		return;
+	__mem->discharge(compo_tdict, table_bytes(__nslots), 0);
+	delete [] __ctrl;
+	delete [] __slots;
+	__ctrl = nullptr;
+	__slots = nullptr;
+	__nslots = __size = __nfree = 0;
+}
+
+/// Rebuild the table in `nslots` slots, moving the entries with their hashes
+Tap_NOINLINE void rehash(uint32_t nslots)
+{
+	uint8_t     * ctrl = __ctrl;
+	tdict_entry * slots = __slots;
+	uint32_t      n = __nslots;
+	uint32_t      size = __size;
+
+	new_table(nslots);
+	for (uint32_t j = 0; j < n; j++) {
+		if (ctrl[j] & Tap_DICT_EMPTY)
+			continue;
+		uint32_t i = static_cast<uint32_t>(slots[j].hash >> 7) & (nslots - 1);
+
+		while (__ctrl[i] != Tap_DICT_EMPTY)
+			i = (i + 1) & (nslots - 1);
+		__ctrl[i] = ctrl[j];
+		__slots[i].first.swap(slots[j].first);
+		__slots[i].second = slots[j].second;
+		__slots[i].hash = slots[j].hash;
+	}
+	if (slots != nullptr) {
+		__mem->discharge(compo_tdict, table_bytes(n), 0);
+		delete [] ctrl;
+		delete [] slots;
+	}
+	__size = size;
+	__nfree = max_load(nslots) - size;
+	__version = new_version();
+}
+
+/// @return the slot of the key of `len` bytes at `key`, or __nslots if absent
+uint32_t find_slot(const char * key, std::size_t len, std::size_t hash) const
+{
+	if (__nslots == 0)
+		return 0;
+	uint8_t h7 = static_cast<uint8_t>(hash & 0x7F);
+	uint32_t mask = __nslots - 1;
+
+	for (uint32_t i = static_cast<uint32_t>(hash >> 7) & mask; ; i = (i + 1) & mask) {
+		if (__ctrl[i] == h7) {
+			const tdict_entry & e = __slots[i];
+
+			if (e.hash == hash && e.first.size() == len && std::memcmp(e.first.data(), key, len) == 0)
+				return i;
+		} else if (__ctrl[i] == Tap_DICT_EMPTY)
+			return __nslots;
+	}
+}
+
+/// @return the value of the key of `len` bytes at `key`, added as nil if absent
+Tap_NOINLINE tobj & find_or_add(const char * key, std::size_t len, std::size_t hash)
+{
+	if (__shared != nullptr)
+		unshare();
+	uint32_t i = find_slot(key, len, hash);
+
+	if (i < __nslots)
+		return __slots[i].second;
+	if (__nfree == 0)
+		rehash(__nslots == 0 ? Tap_DICT_MINSLOTS : (__size >= __nslots / 2 ? __nslots * 2 : __nslots));
+	uint32_t mask = __nslots - 1;
+
+	i = static_cast<uint32_t>(hash >> 7) & mask;
+	while ((__ctrl[i] & Tap_DICT_EMPTY) == 0)
+		i = (i + 1) & mask;
+	if (__ctrl[i] == Tap_DICT_EMPTY)
+		__nfree--;
+	__ctrl[i] = static_cast<uint8_t>(hash & 0x7F);
+	__slots[i].first.assign(key, len);
+	__slots[i].hash = hash;
+	__size++;
+	__version = new_version();
+	return __slots[i].second;
+}
+
+/// Delete the entry of slot `i`, then drop its value
+void erase(uint32_t i)
+{
+	if (__shared != nullptr)
+		unshare(); // at the same slots
+	tobj v = __slots[i].second;
+
+	// a slot before an empty one ends no probing
+	if (__ctrl[(i + 1) & (__nslots - 1)] == Tap_DICT_EMPTY) {
+		__ctrl[i] = Tap_DICT_EMPTY;
+		__nfree++;
+	} else
+		__ctrl[i] = Tap_DICT_DELETED;
+	__slots[i].first.clear();
+	__slots[i].second.set_nil();
+	__size--;
+	__version = new_version();
+	v.ddc_ref_clear();
+}
+
 public:
-tdict() {}
+Tap_COMPO_ALLOC(compo_tdict)
+
+/// Iterator over the entries of a dict, in the order of their slots
+class iterator
+{
+private:
+	tdict_entry   * __slots;
+	const uint8_t * __ctrl;
+	uint32_t        __i;
+	uint32_t        __n;
+
+void skip()
+{
+	while (__i < __n && (__ctrl[__i] & Tap_DICT_EMPTY))
+		__i++;
+}
+
+public:
+iterator(tdict_entry * slots, const uint8_t * ctrl, uint32_t i, uint32_t n)
+	: __slots(slots), __ctrl(ctrl), __i(i), __n(n)
+{
+	skip();
+}
+
+tdict_entry & operator*() const
+{
+	return __slots[__i];
+}
+
+tdict_entry * operator->() const
+{
+	return __slots + __i;
+}
+
+iterator & operator++()
+{
+	__i++;
+	skip();
+	return *this;
+}
+
+iterator operator++(int)
+{
+	iterator iter = *this;
+
+	++*this;
+	return iter;
+}
+
+bool operator==(const iterator & iter) const
+{
+	return __i == iter.__i;
+}
+
+bool operator!=(const iterator & iter) const
+{
+	return __i != iter.__i;
+}
+
+};
+
+/// @return a version never taken by any dict (or shape) before
+static uint64_t new_version()
+{
+#ifdef Tap_ATOMIC_REFCTR
+	static std::atomic<uint64_t> ctr(0);
+#else
+	static uint64_t ctr = 0;
+#endif
+	return ++ctr;
+}
+
+tdict()
+{
+	__ctrl = nullptr;
+	__slots = nullptr;
+	__nslots = __size = __nfree = 0;
+	__version = new_version();
+	__mem = tslab::get_current()->get_mem();
+	__shared = nullptr;
+	gc_track();
+}
+
+tdict(const tdict &) = delete;
 
 ~tdict()
 {
-	for (iterator iter = begin(); iter != end(); iter++) {
-		std::pair<std::string, tobj> p = *iter;
-		p.second.ddc_ref_clear();
+	if (__shared != nullptr) {
+		__shared->unref();
+		return;
+	}
+	for (iterator iter = begin(); iter != end(); iter++)
+		iter->second.ddc_ref_clear();
+	free_table();
+}
+
+/// @return the first entry
+iterator begin()
+{
+	return iterator(__slots, __ctrl, 0, __nslots);
+}
+
+/// @return the end of the entries
+iterator end()
+{
+	return iterator(__slots, __ctrl, __nslots, __nslots);
+}
+
+/// @return the number of entries
+std::size_t size() const
+{
+	return __size;
+}
+
+/// Visit the values, or the table shared (see tgc)
+void gc_traverse(tgc_visitf f, void * arg)
+{
+	if (__shared != nullptr) {
+		f(__shared, arg);
+		return;
 	}
+	for (iterator iter = begin(); iter != end(); iter++)
+		tgc::visit(iter->second, f, arg);
+}
+
+/// Drop the keys and values, or the table shared (see tgc)
+void gc_clear()
+{
+	if (__shared != nullptr) {
+		__shared->unref();
+		__shared = nullptr;
+		__ctrl = nullptr;
+		__slots = nullptr;
+		__nslots = __size = __nfree = 0;
+	}
+	for (iterator iter = begin(); iter != end(); iter++)
+		iter->second.ddc_ref_clear();
+	free_table();
+	__version = new_version();
 }
 
 std::string tostring_abbr() const
@@ -699,26 +1504,34 @@ std::string tostring_full() const
 	std::string is;
 	is += "{\n";
 
-	for (auto iter = cbegin(); iter != cend(); iter++) {
-		std::pair<std::string, tobj> p = *iter;
-		is += "\t\"" + p.first + "\" : ";
-		is += p.second.tostring_abbr() + ",\n";
+	for (uint32_t i = 0; i < __nslots; i++) {
+		if (__ctrl[i] & Tap_DICT_EMPTY)
+			continue;
+		is += "\t\"" + __slots[i].first + "\" : ";
+		is += __slots[i].second.tostring_abbr() + ",\n";
 	}
 	is += "}";
 	return is;
 }
 
+/// @return a copy, sharing the table until either of them is changed
 tdict * copy()
 {
 	tdict * dict = new tdict();
 
-	for (iterator iter = begin(); iter != end(); iter++) {
-		std::pair<std::string, tobj> p = *iter;
-		std::string idx = p.first;
-		tobj v = p.second;
-		(*dict)[idx] = v;
-		if (v.get_type() == tcompo) v.get_v_tcompo()->add_refctr();
+	if (__nslots == 0)
+		return dict;
+	if (__shared == nullptr) {
+		__shared = new tdict_shared(__ctrl, __slots, __nslots, __mem);
+		__shared->add_refctr();
 	}
+	__shared->add_refctr();
+	dict->__shared = __shared;
+	dict->__ctrl = __ctrl;
+	dict->__slots = __slots;
+	dict->__nslots = __nslots;
+	dict->__size = __size;
+	dict->__nfree = __nfree;
 	return dict;
 }
 
@@ -734,7 +1547,7 @@ tcompo_type get_compo_type_code() const
 
 long len() const
 {
-	return static_cast<long>(size());
+	return static_cast<long>(__size);
 }
 
 /// tdict is uncomparable
@@ -753,21 +1566,27 @@ void idx(const tobj * params, uint_size_stk nparams, tobj & idxre)
 		twarn(ErrRuntime_ParamsType).warn("tdict::idx", "Should be 'tstr'");
 
 	tstr * str = reinterpret_cast<tstr *>(params->get_v_tcompo());
-	iterator iter = find(*str);
+	uint32_t i = find_slot(str->chars().data(), str->chars().size(), str->hash());
 
-	if (iter != end())
-		idxre = iter->second;
+	if (i < __nslots)
+		idxre = __slots[i].second;
 	else
 		idxre.set_nil();
 }
 
 void set(const std::string & key, const tobj & v)
 {
-	if (this->find(key) != this->end()) {
-		if ((*this)[key].get_v_tcompo() == v.get_v_tcompo()) return;
-		(*this)[key].ddc_ref_clear();
-	}
-	(*this)[key] = v;
+	set_value(find_or_add(key.data(), key.size(), hash_bytes(key.data(), key.size())), v);
+}
+
+/// Set the value `vloc` of a key to `v`
+static void set_value(tobj & vloc, const tobj & v)
+{
+	if (vloc.get_type() == tcompo && v.get_type() == tcompo
+	&& vloc.get_v_tcompo() == v.get_v_tcompo())
+		return;
+	vloc.ddc_ref_clear();
+	vloc = v;
 
 	if (v.get_type() == tcompo)
 		v.get_v_tcompo()->add_refctr();
@@ -782,7 +1601,7 @@ void iset(const tobj * params, uint_size_stk nparams, const tobj & v)
 	if (params->get_v_tcompo()->get_compo_type_code() != compo_tstr)
 		twarn(ErrRuntime_ParamsType).warn("tdict::iset", "Should be 'tstr'");
 	tstr * str = reinterpret_cast<tstr *>(params->get_v_tcompo());
-	set(*str, v);
+	set_value(find_or_add(str->chars().data(), str->chars().size(), str->hash()), v);
 }
 
 void set_append(const tobj * ele)
@@ -806,11 +1625,40 @@ void set_delete(const tobj * idx)
 		twarn(ErrRuntime_RefType).warn("tdict::pop", "Should be 'tstr'");
 
 	tstr * str = reinterpret_cast<tstr *>(idx->get_v_tcompo());
-	iterator iter = find(*str);
+	uint32_t i = find_slot(str->chars().data(), str->chars().size(), str->hash());
 
-	if (iter != end()) {
-		iter->second.ddc_ref_clear(); erase(iter);
-	}
+	if (i < __nslots)
+		erase(i);
+}
+
+/** @return the version of the keys of the dict
+ *  @details Versions are unique among all the dicts. The values stay at the
+ *  same place while the keys are not changed (the table being rebuilt only
+ *  to add a key, or copied once no longer shared), so that a value found in
+ *  a dict of the same version is still there.
+ */
+uint64_t get_version() const
+{
+	return __version;
+}
+
+/** @return the value of `key` (nullptr if absent), looked up only if the keys
+ *  have been changed since the last lookup by `cache`. The table is no longer
+ *  shared if the value is to be set (see `set_value`)
+ */
+tobj * find_cached(tkeycache & cache, const char * key, bool set)
+{
+	if (set && __shared != nullptr)
+		unshare();
+	if (cache.dict == this && cache.version == __version)
+		return cache.v;
+	std::size_t len = std::strlen(key);
+	uint32_t i = find_slot(key, len, hash_bytes(key, len));
+
+	cache.dict = this;
+	cache.version = __version;
+	cache.v = i < __nslots ? &__slots[i].second : nullptr;
+	return cache.v;
 }
 
 /// keys are deep copy
@@ -831,8 +1679,7 @@ tlist * values()
 	tlist * myvalues = new tlist();
 
 	for (iterator iter = begin(); iter != end(); iter++) {
-		std::pair<std::string, tobj> p = *iter;
-		tobj value = p.second;
+		tobj value = iter->second;
 		myvalues->set_append(&value);
 	}
 	return myvalues;
@@ -853,11 +1700,312 @@ void add_obj(const char * fname, tobj o)
 
 };
 
+/** Shape of records: their keys and the offsets of their values
+ *  @details Shared by the records created by the dict literals of the same
+ *  constant keys (see tlib::bind_keys) and never changed. The last of the
+ *  library and the records referring to it deletes it.
+ */
+class tshape
+{
+private:
+	std::vector<std::string> __keys;                          /// keys by offset
+	std::unordered_map<std::string, uint_size_obj> __offsets; /// offsets by key
+	uint64_t __version;                                       /// unique id
+	uint32_t __refctr;
+
+public:
+tshape(const std::vector<std::string> & keys) : __keys(keys)
+{
+	for (uint_size_obj i = 0; i < __keys.size(); i++)
+		__offsets[__keys[i]] = i;
+	__version = tdict::new_version();
+	__refctr = 0;
+}
+
+/// Add a reference to this shape
+void add_refctr()
+{
+	__refctr++;
+}
+
+/// Remove a reference to this shape, which is deleted with the last one
+void ddc_refctr()
+{
+	if (--__refctr == 0)
+		delete this;
+}
+
+/// @return the number of keys
+uint_size_obj size() const
+{
+	return static_cast<uint_size_obj>(__keys.size());
+}
+
+/// @return the key at `offset`
+const std::string & get_key(uint_size_obj offset) const
+{
+	return __keys[offset];
+}
+
+/// @return the keys by offset
+const std::vector<std::string> & get_keys() const
+{
+	return __keys;
+}
+
+/// @return the offset of `key`, or size() if absent
+uint_size_obj find(const std::string & key) const
+{
+	auto iter = __offsets.find(key);
+	return iter == __offsets.end() ? size() : iter->second;
+}
+
+/// @return a version never taken by any dict or other shape
+uint64_t get_version() const
+{
+	return __version;
+}
+
+};
+
+/** Record. Created by `{key:value, ...}` of constant string keys
+ *  @details A dict whose values are kept in an array, by the offsets of the
+ *  keys in a shared shape. Once a key is added or deleted, its values are
+ *  moved to a real dict, by which the record then works.
+ */
+class trecord : public tcompo_v
+{
+private:
+	tshape * __shape;  /// shape (nullptr once moved to __dict)
+	tobj   * __values; /// values by the offsets of the keys in the shape
+	tdict  * __dict;   /// dict, once a key is added or deleted
+
+/// Move the values to a dict
+void move_to_dict()
+{
+	__dict = new tdict();
+
+	for (uint_size_obj i = 0; i < __shape->size(); i++) {
+		__dict->set(__shape->get_key(i), __values[i]);
+		__values[i].ddc_ref_clear();
+	}
+	delete [] __values;
+	__values = nullptr;
+	__shape->ddc_refctr();
+	__shape = nullptr;
+}
+
+/// @return the offset of the string `key`, or the size of the shape if absent
+uint_size_obj find_offset(const tobj * key, const char * func) const
+{
+	if (key->get_type() != tcompo)
+		twarn(ErrRuntime_ParamsType).warn(func, "Should be 'tstr'");
+	if (key->get_v_tcompo()->get_compo_type_code() != compo_tstr)
+		twarn(ErrRuntime_ParamsType).warn(func, "Should be 'tstr'");
+	return __shape->find(reinterpret_cast<tstr *>(key->get_v_tcompo())->chars());
+}
+
+public:
+Tap_COMPO_ALLOC(compo_trecord)
+
+/// Create a record of `shape` of the values `values`
+trecord(tshape * shape, const tobj * values)
+{
+	__shape = shape;
+	__shape->add_refctr();
+	__values = new tobj[shape->size()];
+	__dict = nullptr;
+
+	for (uint_size_obj i = 0; i < shape->size(); i++)
+		tdict::set_value(__values[i], values[i]);
+	gc_track();
+}
+
+~trecord()
+{
+	if (__dict != nullptr) {
+		delete __dict;
+		return;
+	}
+	for (uint_size_obj i = 0; i < __shape->size(); i++)
+		__values[i].ddc_ref_clear();
+	delete [] __values;
+	__shape->ddc_refctr();
+}
+
+/// Visit the values (see tgc)
+void gc_traverse(tgc_visitf f, void * arg)
+{
+	if (__dict != nullptr) {
+		__dict->gc_traverse(f, arg);
+		return;
+	}
+	for (uint_size_obj i = 0; i < __shape->size(); i++)
+		tgc::visit(__values[i], f, arg);
+}
+
+/// Drop the values (see tgc)
+void gc_clear()
+{
+	if (__dict != nullptr) {
+		__dict->gc_clear();
+		return;
+	}
+	for (uint_size_obj i = 0; i < __shape->size(); i++)
+		__values[i].ddc_ref_clear();
+}
+
+std::string tostring_abbr() const
+{
+	return tostring_pointer(get_type(), this);
+}
+
+std::string tostring_full() const
+{
+	if (__dict != nullptr)
+		return __dict->tostring_full();
+	std::string is;
+	is += "{\n";
+
+	for (uint_size_obj i = 0; i < __shape->size(); i++) {
+		is += "\t\"" + __shape->get_key(i) + "\" : ";
+		is += __values[i].tostring_abbr() + ",\n";
+	}
+	is += "}";
+	return is;
+}
+
+tcompo_v * copy()
+{
+	if (__dict != nullptr)
+		return __dict->copy();
+	return new trecord(__shape, __values);
+}
+
+const char * get_type() const
+{
+	return "Dictionary";
+}
+
+tcompo_type get_compo_type_code() const
+{
+	return compo_trecord;
+}
+
+long len() const
+{
+	return __dict != nullptr ? __dict->len() : static_cast<long>(__shape->size());
+}
+
+/// trecord is uncomparable
+bool identical(tcompo_v * v) const
+{
+	return v == this;
+}
+
+/// @return a new dict of the keys and values
+tdict * todict() const
+{
+	if (__dict != nullptr)
+		return __dict->copy();
+	tdict * dict = new tdict();
+
+	for (uint_size_obj i = 0; i < __shape->size(); i++)
+		dict->set(__shape->get_key(i), __values[i]);
+	return dict;
+}
+
+void idx(const tobj * params, uint_size_stk nparams, tobj & idxre)
+{
+	if (__dict != nullptr)
+		return __dict->idx(params, nparams, idxre);
+	if (nparams != 1)
+		twarn(ErrRuntime_ParamsCtr).warn("trecord::idx", "1 parameter");
+	uint_size_obj offset = find_offset(params, "trecord::idx");
+
+	if (offset < __shape->size())
+		idxre = __values[offset];
+	else
+		idxre.set_nil();
+}
+
+void iset(const tobj * params, uint_size_stk nparams, const tobj & v)
+{
+	if (__dict == nullptr && nparams == 1) {
+		uint_size_obj offset = find_offset(params, "trecord::iset");
+
+		if (offset < __shape->size())
+			return tdict::set_value(__values[offset], v);
+	}
+	if (__dict == nullptr)
+		move_to_dict(); // a key is added
+	__dict->iset(params, nparams, v);
+}
+
+void set_append(const tobj * ele)
+{
+	if (__dict == nullptr)
+		move_to_dict();
+	__dict->set_append(ele);
+}
+
+void set_delete(const tobj * idx)
+{
+	if (__dict == nullptr)
+		move_to_dict();
+	__dict->set_delete(idx);
+}
+
+/** @return the value of `key` (nullptr if absent), looked up only on another
+ *  shape than the one of the last lookup by `cache`. `set`: see tdict::find_cached
+ */
+tobj * find_cached(tkeycache & cache, const char * key, bool set)
+{
+	if (__dict != nullptr)
+		return __dict->find_cached(cache, key, set);
+	if (cache.dict != nullptr || cache.version != __shape->get_version()) {
+		cache.dict = nullptr;
+		cache.version = __shape->get_version();
+		cache.offset = __shape->find(key);
+	}
+	return cache.offset < __shape->size() ? __values + cache.offset : nullptr;
+}
+
+/// keys are deep copy
+tlist * keys()
+{
+	if (__dict != nullptr)
+		return __dict->keys();
+	tlist * mykeys = new tlist();
+
+	for (uint_size_obj i = 0; i < __shape->size(); i++) {
+		tobj v(new tstr(__shape->get_key(i)));
+		mykeys->set_append(&v);
+	}
+	return mykeys;
+}
+
+/// values are shallow copy
+tlist * values()
+{
+	if (__dict != nullptr)
+		return __dict->values();
+	tlist * myvalues = new tlist();
+
+	for (uint_size_obj i = 0; i < __shape->size(); i++)
+		myvalues->set_append(__values + i);
+	return myvalues;
+}
+
+};
+
 class ttime : public tcompo_v, public top_sub
 {
 time_t __t;
 
 public:
+Tap_COMPO_ALLOC(compo_time)
+
 ttime()
 {
 	__t = time(nullptr);
@@ -1015,6 +2163,9 @@ inline void set_append(tobj * const params, uint_size_stk len, tobj & vre)
 	case compo_tdict:
 		reinterpret_cast<tdict *>(p_des)->set_append(atom_ele);
 		break;
+	case compo_trecord:
+		reinterpret_cast<trecord *>(p_des)->set_append(atom_ele);
+		break;
 	case compo_tlist:
 		reinterpret_cast<tlist *>(p_des)->set_append(atom_ele);
 		break;
@@ -1108,12 +2259,29 @@ inline void set_delete(tobj * const params, uint_size_stk len, tobj & vre)
 	case compo_tdict:
 		reinterpret_cast<tdict *>(v)->set_delete(atom_idx);
 		break;
+	case compo_trecord:
+		reinterpret_cast<trecord *>(v)->set_delete(atom_idx);
+		break;
 	default:
 		twarn(ErrRuntime_ParamsType).warn("set_delete", "");
 		break;
 	}
 }
 
+/// @return `v` is a dict or a record
+inline bool is_keyed(tcompo_v * v)
+{
+	return v->get_compo_type_code() == compo_tdict || v->get_compo_type_code() == compo_trecord;
+}
+
+/// @return a new dict of the keys and values of a dict or a record `v`
+inline tdict * keyed_to_dict(tcompo_v * v)
+{
+	if (v->get_compo_type_code() == compo_trecord)
+		return reinterpret_cast<trecord *>(v)->todict();
+	return reinterpret_cast<tdict *>(v)->copy();
+}
+
 /// union(set1, set2)
 inline void set_union(tobj * const params, uint_size_stk len, tobj & vre)
 {
@@ -1145,23 +2313,13 @@ inline void set_union(tobj * const params, uint_size_stk len, tobj & vre)
 		vre.set_v(li_new);
 	}
 
-	if (v1->get_compo_type_code() == compo_tdict && v2->get_compo_type_code() == compo_tdict) {
-		tdict * dict_1 = reinterpret_cast<tdict *>(v1);
-		tdict * dict_2 = reinterpret_cast<tdict *>(v2);
-		tdict * dict_new = new tdict();
+	if (is_keyed(v1) && is_keyed(v2)) {
+		tdict * dict_new = keyed_to_dict(v1);
+		tdict * dict_2 = keyed_to_dict(v2);
 
-		for (auto iter = dict_1->begin(); iter != dict_1->end(); iter++) {
-			std::pair<std::string, tobj> e = *iter;
-			(*dict_new)[e.first] = e.second;
-			if (e.second.get_type() == tcompo)
-				e.second.get_v_tcompo()->add_refctr();
-		}
-		for (auto iter = dict_2->begin(); iter != dict_2->end(); iter++) {
-			std::pair<std::string, tobj> p = *iter;
-			(*dict_new)[p.first] = p.second;
-			if (p.second.get_type() == tcompo)
-				p.second.get_v_tcompo()->add_refctr();
-		}
+		for (auto iter = dict_2->begin(); iter != dict_2->end(); iter++)
+			dict_new->set(iter->first, iter->second);
+		delete dict_2;
 		vre.set_v(dict_new);
 	}
 }
@@ -1173,11 +2331,14 @@ inline void dict_keys(tobj* const params, uint_size_stk len, tobj& vre)
 		twarn(ErrRuntime_ParamsCtr).warn("dict_keys", "");
 	if (params->get_type() != tcompo)
 		twarn(ErrRuntime_ParamsType).warn("dict_keys", "");
-	if (params->get_v_tcompo()->get_compo_type_code() != compo_tdict)
-		twarn(ErrRuntime_ParamsType).warn("dict_keys", "");
+	tcompo_v * v = params->get_v_tcompo();
 
-	tdict* dict = reinterpret_cast<tdict *>(params->get_v_tcompo());
-	vre.set_v(dict->keys());
+	if (v->get_compo_type_code() == compo_trecord)
+		vre.set_v(reinterpret_cast<trecord *>(v)->keys());
+	else if (v->get_compo_type_code() == compo_tdict)
+		vre.set_v(reinterpret_cast<tdict *>(v)->keys());
+	else
+		twarn(ErrRuntime_ParamsType).warn("dict_keys", "");
 }
 
 /// values(dict): Get a list of tdict values.
@@ -1187,11 +2348,14 @@ inline void dict_values(tobj* const params, uint_size_stk len, tobj& vre)
 		twarn(ErrRuntime_ParamsCtr).warn("dict_values", "");
 	if (params->get_type() != tcompo)
 		twarn(ErrRuntime_ParamsType).warn("dict_values", "");
-	if (params->get_v_tcompo()->get_compo_type_code() != compo_tdict)
-		twarn(ErrRuntime_ParamsType).warn("dict_values", "");
+	tcompo_v * v = params->get_v_tcompo();
 
-	tdict* dict = reinterpret_cast<tdict *>(params->get_v_tcompo());
-	vre.set_v(dict->values());
+	if (v->get_compo_type_code() == compo_trecord)
+		vre.set_v(reinterpret_cast<trecord *>(v)->values());
+	else if (v->get_compo_type_code() == compo_tdict)
+		vre.set_v(reinterpret_cast<tdict *>(v)->values());
+	else
+		twarn(ErrRuntime_ParamsType).warn("dict_values", "");
 }
 
 /// now()
@@ -79,6 +79,43 @@ inline void tf_nparam(tobj * const params, uint_size_stk len, tobj& vre, tcompo_
 	vre.set_v(static_cast<long>(f->get_dynamic_nparams()));
 }
 
+/// __gc__(): collect the cycles of values at once, return the number of
+/// values freed (see tgc)
+inline void sys_gc(tobj * const, uint_size_stk len, tobj& vre, tcompo_env *)
+{
+	if (len != 0)
+		twarn(ErrRuntime_ParamsCtr).warn("sys_gc", "0 parameter");
+	vre.set_v(static_cast<long>(tgc::get_current()->collect()));
+}
+
+/** __mem__(): the memory of the values of the session (see tmem), a dict of
+ *  the bytes in use, their peak, the limit (0 if unlimited), and the bytes
+ *  ("types") and the number ("values") of the values in use by type
+ */
+inline void sys_mem(tobj * const, uint_size_stk len, tobj& vre, tcompo_env *)
+{
+	if (len != 0)
+		twarn(ErrRuntime_ParamsCtr).warn("sys_mem", "0 parameter");
+	tgc::get_current()->release(); // the values no longer referred
+	tmem_stats stats = tslab::get_current()->get_mem()->get_stats();
+	tdict * dict = new tdict();
+	tdict * types = new tdict();
+	tdict * values = new tdict();
+
+	vre.set_v(dict);
+	dict->set("bytes", tobj(static_cast<long>(stats.bytes)));
+	dict->set("peak", tobj(static_cast<long>(stats.peak)));
+	dict->set("limit", tobj(static_cast<long>(stats.limit)));
+	dict->set("types", tobj(types));
+	dict->set("values", tobj(values));
+	for (uint8_t i = 0; i < Tap_MEM_NTYPES; i++) {
+		if (stats.nvalues[i] == 0 && stats.nbytes[i] == 0)
+			continue;
+		types->set(tmem::type_name(i), tobj(static_cast<long>(stats.nbytes[i])));
+		values->set(tmem::type_name(i), tobj(static_cast<long>(stats.nvalues[i])));
+	}
+}
+
 /// Session level functions Registration
 inline void register_os_sessf(tlib & lib)
 {
@@ -88,6 +125,8 @@ inline void register_os_sessf(tlib & lib)
 	sys->add_obj("__path__", tobj(new tcppsessf(lib_path, "__path__")));
 	sys->add_obj("__param__", tobj(new tcppsessf(tf_param, "__param__")));
 	sys->add_obj("__nparam__", tobj(new tcppsessf(tf_nparam, "__nparam__")));
+	sys->add_obj("__gc__", tobj(new tcppsessf(sys_gc, "__gc__")));
+	sys->add_obj("__mem__", tobj(new tcppsessf(sys_mem, "__mem__")));
 }
 
 /** Management of Tap session through APIs between Tap and C++.
@@ -100,20 +139,62 @@ inline void register_os_sessf(tlib & lib)
 class tsession
 {
 private:
+	tslab  __slab;   ///< allocator and memory accounting of the values of the session
+	tgc    __gc;     ///< cycle collector of the values of the session
 	tlib * __lib;
+	bool __superins; ///< fuse bycodes into superinstructions
+	uint8_t __optlevel; ///< level of static optimization of bycodes (0 - 2)
+
+public:
+/** Scope in which the values are allocated, accounted and collected by a
+ *  session: its slab (with its accounting, see tmem) and its collector are
+ *  made current, and the ones current before are made current again at the
+ *  end of the scope, by an exception too. The methods of tsession run in
+ *  their own scope; the values made by the program embedding the session
+ *  should be made in one.
+ */
+class tscope
+{
+private:
+	tslab * __slab;  ///< slab current before
+	tgc   * __gc;    ///< collector current before
 
 public:
+tscope(tsession & sess)
+{
+	__slab = sess.__slab.enter();
+	__gc = sess.__gc.enter();
+}
+
+~tscope()
+{
+	tgc::leave(__gc);
+	tslab::leave(__slab);
+}
+};
+
 tsession()
 {
+	tscope scope(*this);
+
+	__superins = true;
+	__optlevel = 2;
 	__lib = new tlib();
 	register_os_sessf(*__lib);
 	register_cppfuncs(*__lib);
 	register_for_Eigen_APIs(*__lib);
 }
 
+/// Destroy the library, then free the cycles and release the values no
+/// longer referred, in the scope of the session, then the values left (see
+/// tslab), whose storage out of the slab is not freed
 ~tsession()
 {
+	tscope scope(*this);
+
 	delete __lib;
+	while (__gc.collect() != 0) // values referred by the cycles freed, in cycles too maybe
+		;
 }
 
 /// @return __lib
@@ -122,25 +203,99 @@ tlib * get_lib() const
 	return __lib;
 }
 
+/// @return the statistics of the allocator of the values of the session
+const tslab_stats & get_slab_stats() const
+{
+	return __slab.get_stats();
+}
+
+/// @return the memory of the values of the session, by type
+tmem_stats memory_stats() const
+{
+	return __slab.get_mem()->get_stats();
+}
+
+/** Set the bytes of the values of the session in use at most, beyond which
+ *  allocating a value is a runtime error (see tmem)
+ *  @param limit 0 for no limit (default)
+ */
+void set_memory_limit(uint64_t limit)
+{
+	__slab.get_mem()->set_limit(limit);
+}
+
+/// @return the statistics of the cycle collector of the session
+const tgc_stats & get_gc_stats() const
+{
+	return __gc.get_stats();
+}
+
+/** Set the number of traced values (containers) allocated, or buffered as
+ *  possible roots of cycles, between two collections of cycles
+ *  @param threshold 0 to collect only by `sys::__gc__()`
+ */
+void set_gc_threshold(uint64_t threshold)
+{
+	__gc.set_threshold(threshold);
+}
+
+/// Turn on/off the fusion of bycodes into superinstructions (default on)
+void set_superins(bool superins)
+{
+	__superins = superins;
+}
+
+/// @return whether bycodes are fused into superinstructions
+bool get_superins() const
+{
+	return __superins;
+}
+
+/** Set the level of static optimization of the compiled bycodes
+ *  @param optlevel 0 (none), 1 (control flow and constants pool) or
+ *                  2 (1 and constant folding, default)
+ */
+void set_optlevel(uint8_t optlevel)
+{
+	__optlevel = optlevel;
+}
+
+/// @return the level of static optimization of the compiled bycodes
+uint8_t get_optlevel() const
+{
+	return __optlevel;
+}
+
 /** Compile tap source code file or markdown file to '.tapc' file
  *  @param file (std::string) tap source code file location.
  *  @param interactive (bool) compile in interactive mode
+ *  @return false if failed, the error being printed (the session is left
+ *          usable, e.g. beyond its memory limit)
  */
-void compile_file(const std::string & file, bool interactive = true)
+bool compile_file(const std::string & file, bool interactive = true)
 {
+	tscope scope(*this);
+
 	try {
 		tcp syner(__lib->get_default_v_names(), nullptr, interactive);
+		syner.set_superins(__superins);
+		syner.set_optlevel(__optlevel);
 		syner.compile_file(file, __lib->get_paths());
 	} catch(...) {
-		exit(-1);
+		return false;
 	}
+	return true;
 }
 
 /** Evaluate the compiled tap source code file
  *  @param file (std::string) tap source code file location.
+ *  @return false if failed, the error being printed (the session is left
+ *          usable, e.g. beyond its memory limit)
  */
-void eval_bycodes(const std::string & file)
+bool eval_bycodes(const std::string & file)
 {
+	tscope scope(*this);
+
 	try {
 		std::string binf = file.substr(0, file.find_last_of(".")) + ".tapc";
 		twrapper * wrapper = tanalyser().load_bin_file(binf);
@@ -148,51 +303,70 @@ void eval_bycodes(const std::string & file)
 		__lib->add_path(utils::get_folderpath_from_filepath(binf));  // add path
 		tvm(wrapper->info.tmp_max).eval_bycodes(0, __lib);
 	} catch(...) {
-		exit(-1);
+		return false;
 	}
+	return true;
 }
 
 /** Compile & evaluate file without store the binary codes
  *  @param file (std::string) tap source code file location.
  *  @param interactive (bool) compile in interactive mode
+ *  @return false if failed, the error being printed (the session is left
+ *          usable, e.g. beyond its memory limit)
  */
-void execute_file(const std::string & file, bool interactive = true)
+bool execute_file(const std::string & file, bool interactive = true)
 {
+	tscope scope(*this);
+
 	try {
 		// Add directory to path
 		__lib->add_path(utils::get_folderpath_from_filepath(file));
 
 		// Compile
 		tcp syner(__lib->get_default_v_names(), nullptr, interactive);
+		syner.set_superins(__superins);
+		syner.set_optlevel(__optlevel);
 		twrapper * wrapper = syner.compile_file_2(file, __lib->get_paths());
 
 		// Execution
 		__lib->set_wrapper(wrapper);
 		tvm(wrapper->info.tmp_max).eval_bycodes(0, __lib);
 	} catch(...) {
-		exit(-1);
+		return false;
 	}
+	return true;
 }
 
-/// Compile & evaluate `str`
-void execute_str(const std::string & str, bool interactive = true)
+/** Compile & evaluate `str`
+ *  @return false if failed, the error being printed (the session is left
+ *          usable, e.g. beyond its memory limit)
+ */
+bool execute_str(const std::string & str, bool interactive = true)
 {
+	tscope scope(*this);
+
 	try {
 		twrapper * wrapper = nullptr;
 		tcp syner(__lib->get_default_v_names(), nullptr, interactive);
+		syner.set_superins(__superins);
+		syner.set_optlevel(__optlevel);
 		wrapper = syner.compile_str(str, __lib->get_paths());
 		__lib->set_wrapper(wrapper);
 		tvm(wrapper->info.tmp_max).eval_bycodes(0, __lib);
 	} catch(...) {
-		exit(-1);
+		return false;
 	}
+	return true;
 }
 
 /** Show bycodes of the compiled tap source code file
  *  @param file (std::string) tap source code file location
+ *  @return false if failed, the error being printed
  */
-void show_bycodes(const std::string & file)
+bool show_bycodes(const std::string & file)
 {
+	tscope scope(*this);
+
 	try {
 		std::string binf = file.substr(0, file.find_last_of(".")) + ".tapc";
 		twrapper * wrapper = tanalyser().load_bin_file(binf);
@@ -200,8 +374,9 @@ void show_bycodes(const std::string & file)
 		analyser.display_wrapper(wrapper);
 		analyser.clean_wrapper(wrapper);
 	} catch(...) {
-		exit(-1);
+		return false;
 	}
+	return true;
 }
 
 /** Add a package (tdict)
@@ -210,6 +385,8 @@ void show_bycodes(const std::string & file)
  */
 tdict * add_pkg(const std::string & pkgname)
 {
+	tscope scope(*this);
+
 	return __lib->add_pkg(pkgname);
 }
 
@@ -243,6 +420,8 @@ tobj & get_obj(uint_size_obj loc)
  */
 twrapper * load_bycodes(const std::string & file)
 {
+	tscope scope(*this);
+
 	return tanalyser().load_bin_file(file + "c");
 }
 
@@ -251,6 +430,8 @@ twrapper * load_bycodes(const std::string & file)
  */
 void release_bycodes(twrapper * wrapper)
 {
+	tscope scope(*this);
+
 	tanalyser().clean_wrapper(wrapper);
 }
 
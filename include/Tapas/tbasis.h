@@ -12,10 +12,15 @@
 #include <cstdio>
 #include <cstdint>
 #include <cmath>
+#include <cstring>
 
 /* cpp stl */
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+#include <atomic>
 
 namespace tapas
 {
@@ -46,10 +51,22 @@ typedef size_t uint_size;
 /// Alias for (2^13) - 1 = 8,191
 #define Limit_LR static_cast<uint16_t>(8191)
 
+/// The maximum number of parameter `L` and `R` of the bycode (LRk type) can express.
+/// Alias for (2^11) - 1 = 2,047
+#define Limit_LRk static_cast<uint16_t>(2047)
+
 /// The maximum number of parameter `C` of the bycode (CP tyoe) can express.
 /// Alias for (2^18) - 1 = 262,143
 #define Limit_C static_cast<uint32_t>(262143)
 
+/// The maximum number of parameter `U` of the narrow bycodes (see tbycode) can express.
+/// Alias for (2^24) - 1 = 16,777,215
+#define Limit_U_N static_cast<uint32_t>(16777215)
+
+/// The maximum number of parameter `L` and `R` of the narrow bycodes (LRk type) can express.
+/// Alias for (2^10) - 1 = 1,023
+#define Limit_LRk_N static_cast<uint16_t>(1023)
+
 /// The maximum number of parameter `P` of the bycode (CP tyoe) can express.
 /// Alias for (2^08) - 1 = 255
 #define Limit_P static_cast<uint8_t>(255)
@@ -85,6 +102,12 @@ typedef uint8_t  uint_size_stk;
 /// Alias for Limit_P (255), the limit of VM stack
 #define REGLIST_SIZE_LIMIT Limit_P
 
+/// The number of objects in the value stack of a virtual machine, which is
+/// shared by the temporary objects and registers of all its call frames
+#ifndef VMSTACK_SIZE_LIMIT
+#define VMSTACK_SIZE_LIMIT static_cast<uint32_t>(262144)
+#endif
+
 /// Mark for cpp functions whose nparams is undetermined
 #define UNDEF_NPARAMS REGLIST_SIZE_LIMIT
 
@@ -94,6 +117,14 @@ typedef uint8_t  uint_size_stk;
 /// Mark that the object is not an environmental object
 #define UNDEF_ENVLOC OBJLIST_SIZE_LIMIT
 
+/// An environmental object is addressed by (hops, slot): its location `slot`
+/// in the environment `hops` levels above. In an operand of LRk bycodes,
+/// `slot` takes the low ENVLOC_SLOT_BITS bits and `hops` the rest.
+#define ENVLOC_SLOT_BITS 7
+#define ENVLOC_LRk(hops, slot) static_cast<uint16_t>(((hops) << ENVLOC_SLOT_BITS) | (slot))
+#define ENVLOC_LRk_HOPS(loc) static_cast<uint_size_obj>((loc) >> ENVLOC_SLOT_BITS)
+#define ENVLOC_LRk_SLOT(loc) static_cast<uint_size_obj>((loc) & ((1 << ENVLOC_SLOT_BITS) - 1))
+
 /** Type of Tap bycodes
  *  @details See the file tap_bycs.h for more details of their operations.
  *  The type of bycodes in Tap includes
@@ -102,6 +133,7 @@ typedef uint8_t  uint_size_stk;
  *  - **CP** (2 parameters)
  *  - **LR** (2 parameters)
  *  - **Lbi** (3 parameters)
+ *  - **LRk** (3 parameters)
  *
  *  Explanations of the parameters of Tap bycodes:
  *  - **nreg**    - number of objects pop out of stack.
@@ -109,6 +141,7 @@ typedef uint8_t  uint_size_stk;
  *  - **cloc**    - location of constant in constant list.
  *  - **ncmd**    - number of commands in command list.
  *  - **nparams** - number of parameters to be pushed in stack.
+ *  - **layout**  - operands layout of binary operations, see tbinop_layout.
  */
 enum tins : uint8_t
 {
@@ -117,23 +150,21 @@ enum tins : uint8_t
 	OP_TMPDEL,    ///< U   - nobj
 	OP_THIS,      ///< no params
 	OP_BASE,      ///< no params
-	OP_BREAK,     ///< no params
-	OP_CONTI,     ///< no params
 	OP_RET,       ///< no params
 	OP_IN,        ///< no params
 	OP_PAIR,      ///< no params
 	OP_TO,        ///< no params
 	OP_POPN,      ///< LR  - nreg, interactive
-	OP_POPCOV,    ///< LR  - oloc, isenv
-	OP_LOOPAS,    ///< LR  - oloc, isenv
-	OP_LOOPIAS,   ///< LR  - oloc, isenv
-	OP_LOOPLAS,   ///< LR  - oloc, isenv
-	OP_LOOPGAS,   ///< LR  - oloc, isenv
+	OP_POPCOV,    ///< LR  - oloc, ienv (0: tmp, else 1 + hops)
+	OP_LOOPAS,    ///< LR  - oloc, ienv (0: tmp, else 1 + hops)
+	OP_LOOPIAS,   ///< LR  - oloc, ienv (0: tmp, else 1 + hops)
+	OP_LOOPLAS,   ///< LR  - oloc, ienv (0: tmp, else 1 + hops)
+	OP_LOOPGAS,   ///< LR  - oloc, ienv (0: tmp, else 1 + hops)
 	OP_JPF,       ///< U   - ncmd
 	OP_JPB,       ///< U   - ncmd
 	OP_CJPFPOP,   ///< U   - ncmd
 	OP_CJPBPOP,   ///< U   - ncmd
-	OP_PUSHX,     ///< LR  - oloc, isenv
+	OP_PUSHX,     ///< LR  - oloc, ienv (0: tmp, else 1 + hops)
 	OP_PUSHI,     ///< U   - cloc
 	OP_PUSHD,     ///< U   - cloc
 	OP_PUSHB,     ///< U   - cloc
@@ -146,23 +177,95 @@ enum tins : uint8_t
 	OP_EVALSF,    ///< U   - nparams
 	OP_EVALCF,    ///< U   - nparams
 	OP_EVALTF,    ///< U   - nparams
-	OP_IDXL,      ///< Lbi - oloc, nreg, isenv
-	OP_PUSHF,     ///< U   - ncmd
-	OP_ADD,       ///< LR  - oloc, oloc
-	OP_SUB,       ///< LR  - oloc, oloc
-	OP_MUL,       ///< LR  - oloc, oloc
-	OP_DIV,       ///< LR  - oloc, oloc
-	OP_MOD,       ///< LR  - oloc, oloc
-	OP_POW,       ///< LR  - oloc, oloc
-	OP_MMUL,      ///< LR  - oloc, oloc
-	OP_EQ,        ///< LR  - oloc, oloc
-	OP_NE,        ///< LR  - oloc, oloc
-	OP_GE,        ///< LR  - oloc, oloc
-	OP_SG,        ///< LR  - oloc, oloc
-	OP_LE,        ///< LR  - oloc, oloc
-	OP_SL,        ///< LR  - oloc, oloc
-	OP_AND,       ///< LR  - oloc, oloc
-	OP_OR,        ///< LR  - oloc, oloc
+	OP_IDXL,      ///< Lbi - oloc, nreg, ienv (0: tmp, else 1 + hops)
+	OP_PUSHF,     ///< U   - ncmd (skipped by the OP_PUSHP made at loading)
+	OP_ADD,       ///< LRk - oloc, oloc, layout
+	OP_SUB,       ///< LRk - oloc, oloc, layout
+	OP_MUL,       ///< LRk - oloc, oloc, layout
+	OP_DIV,       ///< LRk - oloc, oloc, layout
+	OP_MOD,       ///< LRk - oloc, oloc, layout
+	OP_POW,       ///< LRk - oloc, oloc, layout
+	OP_MMUL,      ///< LRk - oloc, oloc, layout
+	OP_EQ,        ///< LRk - oloc, oloc, layout
+	OP_NE,        ///< LRk - oloc, oloc, layout
+	OP_GE,        ///< LRk - oloc, oloc, layout
+	OP_SG,        ///< LRk - oloc, oloc, layout
+	OP_LE,        ///< LRk - oloc, oloc, layout
+	OP_SL,        ///< LRk - oloc, oloc, layout
+	OP_AND,       ///< LRk - oloc, oloc, layout
+	OP_OR,        ///< LRk - oloc, oloc, layout
+	OP_TEVAL,     ///< U   - nparams (OP_EVAL in tail position, before OP_RET)
+	OP_PUSHREC,   ///< U   - nkeys (followed by OP_PUSHS of the keys)
+	OP_FORPREP,   ///< no params (`start to end` of a for loop counted on stack)
+	OP_FORLOOP,   ///< LR  - oloc, ienv (0: tmp, else 1 + hops)
+	/* narrow bycodes: compile time only, quickened, fused or bound, see tbycode */
+	OP_BREAK,     ///< no params (compile time only)
+	OP_CONTI,     ///< no params (compile time only)
+	OP_ADD_II,    ///< LRk - oloc, oloc, layout (quickened from OP_ADD)
+	OP_SUB_II,    ///< LRk - oloc, oloc, layout (quickened from OP_SUB)
+	OP_MUL_II,    ///< LRk - oloc, oloc, layout (quickened from OP_MUL)
+	OP_DIV_II,    ///< LRk - oloc, oloc, layout (quickened from OP_DIV)
+	OP_MOD_II,    ///< LRk - oloc, oloc, layout (quickened from OP_MOD)
+	OP_POW_II,    ///< LRk - oloc, oloc, layout (quickened from OP_POW)
+	OP_EQ_II,     ///< LRk - oloc, oloc, layout (quickened from OP_EQ)
+	OP_NE_II,     ///< LRk - oloc, oloc, layout (quickened from OP_NE)
+	OP_GE_II,     ///< LRk - oloc, oloc, layout (quickened from OP_GE)
+	OP_SG_II,     ///< LRk - oloc, oloc, layout (quickened from OP_SG)
+	OP_LE_II,     ///< LRk - oloc, oloc, layout (quickened from OP_LE)
+	OP_SL_II,     ///< LRk - oloc, oloc, layout (quickened from OP_SL)
+	OP_ADD_DD,    ///< LRk - oloc, oloc, layout (quickened from OP_ADD)
+	OP_SUB_DD,    ///< LRk - oloc, oloc, layout (quickened from OP_SUB)
+	OP_MUL_DD,    ///< LRk - oloc, oloc, layout (quickened from OP_MUL)
+	OP_DIV_DD,    ///< LRk - oloc, oloc, layout (quickened from OP_DIV)
+	OP_MOD_DD,    ///< LRk - oloc, oloc, layout (quickened from OP_MOD)
+	OP_POW_DD,    ///< LRk - oloc, oloc, layout (quickened from OP_POW)
+	OP_EQ_DD,     ///< LRk - oloc, oloc, layout (quickened from OP_EQ)
+	OP_NE_DD,     ///< LRk - oloc, oloc, layout (quickened from OP_NE)
+	OP_GE_DD,     ///< LRk - oloc, oloc, layout (quickened from OP_GE)
+	OP_SG_DD,     ///< LRk - oloc, oloc, layout (quickened from OP_SG)
+	OP_LE_DD,     ///< LRk - oloc, oloc, layout (quickened from OP_LE)
+	OP_SL_DD,     ///< LRk - oloc, oloc, layout (quickened from OP_SL)
+	OP_INCR,      ///< U   - cloc (fused: OP_PUSHI, OP_ADD, OP_POPCOV)
+	OP_DECR,      ///< U   - cloc (fused: OP_PUSHI, OP_SUB, OP_POPCOV)
+	OP_ADDXC,     ///< U   - cloc (fused: OP_PUSHI, OP_ADD)
+	OP_SUBXC,     ///< U   - cloc (fused: OP_PUSHI, OP_SUB)
+	OP_EQJPF,     ///< LRk - oloc, oloc, layout (fused: OP_EQ, OP_CJPFPOP)
+	OP_NEJPF,     ///< LRk - oloc, oloc, layout (fused: OP_NE, OP_CJPFPOP)
+	OP_GEJPF,     ///< LRk - oloc, oloc, layout (fused: OP_GE, OP_CJPFPOP)
+	OP_SGJPF,     ///< LRk - oloc, oloc, layout (fused: OP_SG, OP_CJPFPOP)
+	OP_LEJPF,     ///< LRk - oloc, oloc, layout (fused: OP_LE, OP_CJPFPOP)
+	OP_SLJPF,     ///< LRk - oloc, oloc, layout (fused: OP_SL, OP_CJPFPOP)
+	OP_PUSHP,     ///< U   - iproto (made at loading: OP_PUSHINFO x 4, OP_PUSHF)
+	OP_PUSHK,     ///< U   - icache (made at loading: OP_PUSHS, OP_PUSHX, OP_IDXR)
+	OP_IDXLK,     ///< U   - icache (made at loading: OP_PUSHS, OP_IDXL)
+	OP_PUSHRECS,  ///< U   - ishape (made at loading: OP_PUSHREC)
+	OP_PUSHSC,    ///< U   - cloc (made at loading: OP_PUSHS read only)
+};
+
+/// Number of the wide bycodes (see tbycode), the first narrow bycode
+#define OP_NWIDE static_cast<uint8_t>(OP_BREAK)
+
+/// Number of all the bycodes
+#define OP_NINS static_cast<uint8_t>(OP_PUSHSC + 1)
+
+/** Operands layout of binary operations (OP_ADD : OP_OR)
+ *  @details Each side of a binary operation is either a value on the top of
+ *  VM stack (v), an environmental object (e) or a temporary object (t).
+ *  When both sides are objects the result is pushed to VM stack, otherwise
+ *  it overwrites the value operand. Environmental objects are addressed by
+ *  ENVLOC_LRk.
+ */
+enum tbinop_layout : uint8_t
+{
+	BINOP_VV,     ///< value value (L = 0, R = 1 are locations in VM stack)
+	BINOP_EV,     ///< env value
+	BINOP_VE,     ///< value env
+	BINOP_EE,     ///< env env
+	BINOP_TV,     ///< tmp value
+	BINOP_VT,     ///< value tmp
+	BINOP_TT,     ///< tmp tmp
+	BINOP_ET,     ///< env tmp
+	BINOP_TE,     ///< tmp env
 };
 
 /**  The errors in Tap are emitted whenever there is something wrong
@@ -190,6 +293,7 @@ enum terror_type : uint8_t
 	ErrCompile_CSTOutOfLimit,   ///< Compile Error - Constants Overflow
 	ErrCompile_ReturnTmpObj,    ///< Compile Error - Return Temporary Object
 	ErrCompile_InvalidFile,     ///< Compile Error - Invalid File Name/Suffix
+	ErrCompile_OutOfLoop,       ///< Compile Error - Break/Continue out of Loop
 
 	ErrSession_IO,              ///< Session Error - IO
 
@@ -209,6 +313,8 @@ enum terror_type : uint8_t
 	ErrRuntime_StringEval,      ///< Runtime Error - String Evaluation
 	ErrRuntime_EnvInconsis,     ///< Runtime Error - Environment Inconsistecy
 	ErrRuntime_RecurseRefRet,   ///< Runtime Error - Return Local Reference in Recursion
+	ErrRuntime_StackOverflow,   ///< Runtime Error - VM Stack Overflow
+	ErrRuntime_MemLimit,        ///< Runtime Error - Memory Limit Exceeded
 };
 
 /// Throw a warning and stop the Tap process
@@ -281,6 +387,9 @@ void warn(const std::string & fname, const std::string & info)
 	case ErrCompile_InvalidFile:
 		printf("Compile Error - Invalid File Name/Suffix");
 		break;
+	case ErrCompile_OutOfLoop:
+		printf("Compile Error - Break/Continue out of Loop");
+		break;
 
 	case ErrSession_IO:
 		printf("Session Error - IO");
@@ -334,6 +443,12 @@ void warn(const std::string & fname, const std::string & info)
 	case ErrRuntime_RecurseRefRet:
 		printf("Runtime Error - Return Local Reference in Recursion");
 		break;
+	case ErrRuntime_StackOverflow:
+		printf("Runtime Error - VM Stack Overflow");
+		break;
+	case ErrRuntime_MemLimit:
+		printf("Runtime Error - Memory Limit Exceeded");
+		break;
 	}
 	printf(" - tapas::%s.\n", fname.c_str());
 	printf("  %s\n", info.c_str());
@@ -8,10 +8,16 @@ namespace tapas
 
 /** Single Tap bycode
  *  @details This class defines the basic type of bycodes in Tap.
- *  There are 5 basic types: no params, U, CP, LR and Lbi.
+ *  There are 6 basic types: no params, U, CP, LR, Lbi and LRk.
  *  The construction methods and parameters-picking methods
  *  of each bycodes are also defined here.
  *  There is no Limit checking in the definition of tbycode
+ *
+ *  The instruction of a wide bycode takes the first 6 bits, and its
+ *  parameters the other 26. The narrow bycodes (from OP_NWIDE on: compile
+ *  time only, or made by quickening, fusing and binding) do not fit in the 6
+ *  bits: they take an 8 bits code (the 6 bits above OP_NWIDE, plus 2 bits of
+ *  page), and their parameters the other 24, read by the `_n` methods.
  */
 class tbycode
 {
@@ -19,8 +25,41 @@ private:
 /// Instruction - uint32_t value
 uint32_t __basic_ins;
 
+/// Number of the codes of a page (the 6 bits left by the encoded bycodes)
+static constexpr uint8_t NCODES_PAGE = 64 - OP_NWIDE;
+
+static_assert(OP_NINS - OP_NWIDE <= 4 * NCODES_PAGE, "too many narrow bycodes");
+
+/// @return the 8 bits code of the narrow bycode `ins`
+static uint32_t code_of(uint8_t ins)
+{
+	uint8_t r = ins - OP_NWIDE;
+	return (OP_NWIDE + r % NCODES_PAGE) | (r / NCODES_PAGE) << 6;
+}
+
+/// @return whether `ins` is of LRk type (binary operations)
+static bool is_binop(uint8_t ins)
+{
+	return (ins >= OP_ADD && ins <= OP_OR)
+		|| (ins >= OP_ADD_II && ins <= OP_SL_DD)
+		|| (ins >= OP_EQJPF && ins <= OP_SLJPF);
+}
+
 public:
 
+/// @return whether `ins` is a narrow bycode
+static bool is_narrow(uint8_t ins)
+{
+	return ins >= OP_NWIDE;
+}
+
+/// @return the instruction of the lower 8 bits `code` of a bycode
+static tins ins_of(uint8_t code)
+{
+	uint8_t c = code & 63;
+	return c < OP_NWIDE ? tins(c) : tins(c + NCODES_PAGE * (code >> 6));
+}
+
 /// Generate the bycode of OP_PASS
 tbycode()
 {
@@ -30,17 +69,15 @@ tbycode()
 /// Generate a bycode without parameters
 tbycode(uint8_t ins)
 {
-	__basic_ins = 0; __basic_ins += ((ins << 2) >> 2);
+	__basic_ins = is_narrow(ins) ? code_of(ins) : ins;
 }
 
 /** Generate instructions of U type:
- *  U size = 26 bite.
+ *  U size = 26 bite (24 bite of narrow bycodes).
  */
 tbycode(uint8_t ins, uint32_t u)
 {
-	__basic_ins = 0;
-	__basic_ins += (u << 6);
-	__basic_ins += ((ins << 2) >> 2);
+	__basic_ins = is_narrow(ins) ? (u << 8) + code_of(ins) : (u << 6) + ins;
 }
 
 /// @return unsigned integer U of instruction Op-U
@@ -49,6 +86,12 @@ uint32_t get_U()
 	return __basic_ins >> 6;
 }
 
+/// @return unsigned integer U of narrow instruction Op-U
+uint32_t get_U_n()
+{
+	return __basic_ins >> 8;
+}
+
 /// Add A to U for instructions Op-U
 void plus_U_by(uint32_t A)
 {
@@ -135,18 +178,112 @@ uint8_t get_i()
 	return (__basic_ins >> 27);
 }
 
+/** Generate instructions of LRk type (binary operations):
+ *  L size = 11 bite (10 bite of narrow bycodes);
+ *  R size = 11 bite (10 bite of narrow bycodes);
+ *  k size =  4 bite.
+ */
+tbycode(uint8_t ins, uint16_t L, uint16_t R, tbinop_layout k)
+{
+	uint32_t iL = L;
+	uint32_t iR = R;
+	uint32_t ik = k;
+
+	if (is_narrow(ins))
+		__basic_ins = (ik << 28) + ((iR << 22) >> 4) + ((iL << 22) >> 14) + code_of(ins);
+	else
+		__basic_ins = (ik << 28) + ((iR << 21) >> 4) + ((iL << 21) >> 15) + ins;
+}
+
+/// @return uint16_t of L of instruction Op-L-R-k
+uint16_t get_Lk()
+{
+	return ((__basic_ins << 15) >> 21);
+}
+
+/// @return uint16_t of R of instruction Op-L-R-k
+uint16_t get_Rk()
+{
+	return ((__basic_ins << 4) >> 21);
+}
+
+/// @return uint16_t of L of narrow instruction Op-L-R-k
+uint16_t get_Lk_n()
+{
+	return ((__basic_ins << 14) >> 22);
+}
+
+/// @return uint16_t of R of narrow instruction Op-L-R-k
+uint16_t get_Rk_n()
+{
+	return ((__basic_ins << 4) >> 22);
+}
+
+/// @return operands layout k of instruction Op-L-R-k
+tbinop_layout get_k()
+{
+	return tbinop_layout(__basic_ins >> 28);
+}
+
+/// @return the lower 8 bits of the bycode, of which ins_of tells the instruction
+uint8_t code()
+{
+	return static_cast<uint8_t>(__basic_ins);
+}
+
 /// @return instruction type
 tins ins()
 {
-	return tins((__basic_ins << 26) >> 26);
+	return ins_of(code());
 }
 
-/// Set instruction type
-void set_ins(uint8_t ins)
+/** Set instruction type
+ *  @details From or to a narrow bycode, the parameters are moved to the
+ *  layout of `ins`, which fails if they do not fit
+ *  @return false if the parameters do not fit (nothing is done)
+ */
+bool set_ins(uint8_t ins)
 {
-	__basic_ins >>= 6;
-	__basic_ins <<= 6;
-	__basic_ins += ((ins << 2) >> 2);
+	tins from = this->ins();
+
+	if (!is_narrow(from) && !is_narrow(ins)) {
+		__basic_ins >>= 6;
+		__basic_ins <<= 6;
+		__basic_ins += ins;
+		return true;
+	}
+	if (is_binop(ins)) {
+		bool rt = is_narrow(from);
+		uint16_t L = rt ? get_Lk_n() : get_Lk();
+		uint16_t R = rt ? get_Rk_n() : get_Rk();
+
+		if (is_narrow(ins) && (L > Limit_LRk_N || R > Limit_LRk_N))
+			return false;
+		*this = tbycode(ins, L, R, get_k());
+		return true;
+	}
+	uint32_t U = is_narrow(from) ? get_U_n() : get_U();
+
+	if (is_narrow(ins) && U > Limit_U_N)
+		return false;
+	*this = tbycode(ins, U);
+	return true;
+}
+
+/// @return a string of the parameters of instruction Op-L-R-k
+std::string binop_params_tostring()
+{
+	static const char * layouts[] = {
+		"vv", "ev", "ve", "ee", "tv", "vt", "tt", "et", "te"
+	};
+	tbinop_layout k = get_k();
+	bool rt = is_narrow(ins());
+	std::string is = std::to_string(rt ? get_Lk_n() : get_Lk()) + "  "
+		+ std::to_string(rt ? get_Rk_n() : get_Rk());
+
+	if (k <= BINOP_TE)
+		is += "  " + std::string(layouts[k]);
+	return is;
 }
 
 /// @return a string of the instruction
@@ -256,6 +393,37 @@ std::string tostring()
 		is += "OP_PUSHDICT ";
 		is += std::to_string(get_U());
 		break;
+	case OP_PUSHP:
+		is += "OP_PUSHP    ";
+		is += std::to_string(get_U_n());
+		break;
+	case OP_PUSHK:
+		is += "OP_PUSHK    ";
+		is += std::to_string(get_U_n());
+		break;
+	case OP_IDXLK:
+		is += "OP_IDXLK    ";
+		is += std::to_string(get_U_n());
+		break;
+	case OP_PUSHREC:
+		is += "OP_PUSHREC  ";
+		is += std::to_string(get_U());
+		break;
+	case OP_PUSHRECS:
+		is += "OP_PUSHRECS ";
+		is += std::to_string(get_U_n());
+		break;
+	case OP_PUSHSC:
+		is += "OP_PUSHSC   ";
+		is += std::to_string(get_U_n());
+		break;
+	case OP_FORPREP:
+		is += "OP_FORPREP  ";
+		break;
+	case OP_FORLOOP:
+		is += "OP_FORLOOP  ";
+		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		break;
 	case OP_PUSHINFO:
 		is += "OP_PUSHINFO ";
 		is += std::to_string(get_U());
@@ -295,63 +463,203 @@ std::string tostring()
 		break;
 	case OP_ADD:
 		is += "OP_ADD      ";
-		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		is += binop_params_tostring();
 		break;
 	case OP_SUB:
 		is += "OP_SUB      ";
-		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		is += binop_params_tostring();
 		break;
 	case OP_MUL:
 		is += "OP_MUL      ";
-		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		is += binop_params_tostring();
 		break;
 	case OP_DIV:
 		is += "OP_DIV      ";
-		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		is += binop_params_tostring();
 		break;
 	case OP_MOD:
 		is += "OP_MOD      ";
-		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		is += binop_params_tostring();
 		break;
 	case OP_POW:
 		is += "OP_POW      ";
-		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		is += binop_params_tostring();
 		break;
 	case OP_MMUL:
 		is += "OP_MMUL     ";
-		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		is += binop_params_tostring();
 		break;
 	case OP_EQ:
 		is += "OP_EQ       ";
-		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		is += binop_params_tostring();
 		break;
 	case OP_NE:
 		is += "OP_NE       ";
-		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		is += binop_params_tostring();
 		break;
 	case OP_GE:
 		is += "OP_GE       ";
-		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		is += binop_params_tostring();
 		break;
 	case OP_SG:
 		is += "OP_SG       ";
-		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		is += binop_params_tostring();
 		break;
 	case OP_LE:
 		is += "OP_LE       ";
-		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		is += binop_params_tostring();
 		break;
 	case OP_SL:
 		is += "OP_SL       ";
-		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		is += binop_params_tostring();
 		break;
 	case OP_AND:
 		is += "OP_AND      ";
-		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		is += binop_params_tostring();
 		break;
 	case OP_OR:
 		is += "OP_OR       ";
-		is += std::to_string(get_L()) + "  " + std::to_string(get_R());
+		is += binop_params_tostring();
+		break;
+	case OP_ADD_II:
+		is += "OP_ADD_II   ";
+		is += binop_params_tostring();
+		break;
+	case OP_SUB_II:
+		is += "OP_SUB_II   ";
+		is += binop_params_tostring();
+		break;
+	case OP_MUL_II:
+		is += "OP_MUL_II   ";
+		is += binop_params_tostring();
+		break;
+	case OP_DIV_II:
+		is += "OP_DIV_II   ";
+		is += binop_params_tostring();
+		break;
+	case OP_MOD_II:
+		is += "OP_MOD_II   ";
+		is += binop_params_tostring();
+		break;
+	case OP_POW_II:
+		is += "OP_POW_II   ";
+		is += binop_params_tostring();
+		break;
+	case OP_EQ_II:
+		is += "OP_EQ_II    ";
+		is += binop_params_tostring();
+		break;
+	case OP_NE_II:
+		is += "OP_NE_II    ";
+		is += binop_params_tostring();
+		break;
+	case OP_GE_II:
+		is += "OP_GE_II    ";
+		is += binop_params_tostring();
+		break;
+	case OP_SG_II:
+		is += "OP_SG_II    ";
+		is += binop_params_tostring();
+		break;
+	case OP_LE_II:
+		is += "OP_LE_II    ";
+		is += binop_params_tostring();
+		break;
+	case OP_SL_II:
+		is += "OP_SL_II    ";
+		is += binop_params_tostring();
+		break;
+	case OP_ADD_DD:
+		is += "OP_ADD_DD   ";
+		is += binop_params_tostring();
+		break;
+	case OP_SUB_DD:
+		is += "OP_SUB_DD   ";
+		is += binop_params_tostring();
+		break;
+	case OP_MUL_DD:
+		is += "OP_MUL_DD   ";
+		is += binop_params_tostring();
+		break;
+	case OP_DIV_DD:
+		is += "OP_DIV_DD   ";
+		is += binop_params_tostring();
+		break;
+	case OP_MOD_DD:
+		is += "OP_MOD_DD   ";
+		is += binop_params_tostring();
+		break;
+	case OP_POW_DD:
+		is += "OP_POW_DD   ";
+		is += binop_params_tostring();
+		break;
+	case OP_EQ_DD:
+		is += "OP_EQ_DD    ";
+		is += binop_params_tostring();
+		break;
+	case OP_NE_DD:
+		is += "OP_NE_DD    ";
+		is += binop_params_tostring();
+		break;
+	case OP_GE_DD:
+		is += "OP_GE_DD    ";
+		is += binop_params_tostring();
+		break;
+	case OP_SG_DD:
+		is += "OP_SG_DD    ";
+		is += binop_params_tostring();
+		break;
+	case OP_LE_DD:
+		is += "OP_LE_DD    ";
+		is += binop_params_tostring();
+		break;
+	case OP_SL_DD:
+		is += "OP_SL_DD    ";
+		is += binop_params_tostring();
+		break;
+	case OP_INCR:
+		is += "OP_INCR     ";
+		is += std::to_string(get_U_n());
+		break;
+	case OP_DECR:
+		is += "OP_DECR     ";
+		is += std::to_string(get_U_n());
+		break;
+	case OP_ADDXC:
+		is += "OP_ADDXC    ";
+		is += std::to_string(get_U_n());
+		break;
+	case OP_SUBXC:
+		is += "OP_SUBXC    ";
+		is += std::to_string(get_U_n());
+		break;
+	case OP_EQJPF:
+		is += "OP_EQJPF    ";
+		is += binop_params_tostring();
+		break;
+	case OP_NEJPF:
+		is += "OP_NEJPF    ";
+		is += binop_params_tostring();
+		break;
+	case OP_GEJPF:
+		is += "OP_GEJPF    ";
+		is += binop_params_tostring();
+		break;
+	case OP_SGJPF:
+		is += "OP_SGJPF    ";
+		is += binop_params_tostring();
+		break;
+	case OP_LEJPF:
+		is += "OP_LEJPF    ";
+		is += binop_params_tostring();
+		break;
+	case OP_SLJPF:
+		is += "OP_SLJPF    ";
+		is += binop_params_tostring();
+		break;
+	case OP_TEVAL:
+		is += "OP_TEVAL    ";
+		is += std::to_string(get_U());
 		break;
 	}
 	return is;
@@ -561,6 +869,36 @@ struct twrapper_consts
 	double * cdbls;   ///< double float constants list
 };
 
+/** Prototype of the functions of a function literal (or kappa block)
+ *  @details Made once when a wrapper is loaded (see tanalyser::make_protos)
+ *  and never changed. It is shared by the wrapper and all the functions
+ *  created by the literal, the last of which deletes it.
+ */
+struct tproto
+{
+	uint_size_cmd cmdloc;  ///< location of the body in the bycodes
+	uint_size_cmd ncmds;   ///< number of bycodes of the body
+	uint_size_obj nobjs;   ///< maximum number of environmental objects
+	uint_size_obj ntmps;   ///< maximum number of temporary objects
+	uint_size_stk regmax;  ///< maximum number of registers used
+	uint_size_stk nparams; ///< number of parameters (UNDEF_NPARAMS for `...`)
+	uint32_t refctr;       ///< number of the wrapper and functions referring
+
+/// Add a reference to this prototype
+void add_refctr()
+{
+	refctr++;
+}
+
+/// Remove a reference to this prototype, which is deleted with the last one
+void ddc_refctr()
+{
+	if (--refctr == 0)
+		delete this;
+}
+
+};
+
 /** Tap bycodes wrapper
  *  @details After compilation, all bycodes, constants and compilation infos
  *  will be stored here as the "plain" values. This is the data that Tap VM
@@ -572,8 +910,17 @@ struct twrapper
 	tbycode * cmdarr;       ///< list of bycodes
 	tcinfo info;            ///< other compilation informations
 	uint_size_cmd ncmds;        ///< number of bycodes
+	uint_size_cmd nprotos;      ///< number of function prototypes
+	tproto ** protos;       ///< function prototypes (made at loading, not stored)
 };
 
+/// Magic number at the beginning of .tapc files ("TAPC")
+#define Tapc_Magic static_cast<uint32_t>(0x43504154)
+
+/// Version of the bycodes format in .tapc files.
+/// Files of other versions must be re-compiled from source.
+#define Tapc_Version static_cast<uint32_t>(10)
+
 /** Tap bycodes management class
  *  @details This class is used for
  *  (1) Static optimization: make bycodes of tvmcmd_vect better.
@@ -586,6 +933,388 @@ struct twrapper
 class tanalyser
 {
 private:
+bool __superins; ///< fuse bycodes into superinstructions
+uint8_t __optlevel; ///< level of static optimization (0 - 2)
+
+/** Fuse common sequences of bycodes into superinstructions
+ *  @details The first bycode of a sequence is rewritten into the fused
+ *  instruction, which reads its parameters from the whole sequence and skips
+ *  the rest of it. The rest of the sequence is left unchanged, so that jumps
+ *  into the middle of a sequence remain valid, and so does the fall back of
+ *  a fused instruction: executing the first bycode of the sequence only.
+ *  - OP_PUSHI c, OP_ADD x 0 ev/tv, OP_POPCOV x 1/0 => OP_INCR c
+ *  - OP_PUSHI c, OP_SUB x 0 ev/tv, OP_POPCOV x 1/0 => OP_DECR c
+ *  - OP_PUSHI c, OP_ADD x 0 ev/tv                  => OP_ADDXC c
+ *  - OP_PUSHI c, OP_SUB x 0 ev/tv                  => OP_SUBXC c
+ *  - OP_EQ L R k, OP_CJPFPOP n                     => OP_EQJPF L R k
+ *    (and so on for OP_NE, OP_GE, OP_SG, OP_LE and OP_SL)
+ *  A sequence whose parameters do not fit the fused instruction (a narrow
+ *  bycode, see tbycode) is not fused.
+ */
+void fuse_superins(tbycode * cmdarr, uint_size_cmd ncmds)
+{
+	for (uint_size_cmd i = 0; i + 1 < ncmds; i++) {
+		tbycode * cmd = cmdarr + i;
+		tins ins_1 = cmd[1].ins();
+
+		switch (cmd[0].ins()) {
+		case OP_PUSHI: {
+			if (ins_1 != OP_ADD && ins_1 != OP_SUB)
+				break;
+			tbinop_layout k = cmd[1].get_k();
+
+			if ((k != BINOP_EV && k != BINOP_TV) || cmd[1].get_Rk() != 0)
+				break;
+			uint16_t x = cmd[1].get_Lk();
+
+			if (i + 2 < ncmds && cmd[2].ins() == OP_POPCOV
+			&& (k == BINOP_EV
+			? cmd[2].get_L() == ENVLOC_LRk_SLOT(x) && cmd[2].get_R() == ENVLOC_LRk_HOPS(x) + 1
+			: cmd[2].get_L() == x && cmd[2].get_R() == 0)) {
+				if (cmd[0].set_ins(ins_1 == OP_ADD ? OP_INCR : OP_DECR))
+					i += 2;
+			} else {
+				if (cmd[0].set_ins(ins_1 == OP_ADD ? OP_ADDXC : OP_SUBXC))
+					i += 1;
+			}
+			break;
+		}
+		case OP_EQ: case OP_NE: case OP_GE: case OP_SG: case OP_LE: case OP_SL: {
+			if (ins_1 != OP_CJPFPOP)
+				break;
+			if (cmd[0].set_ins(cmd[0].ins() - OP_EQ + OP_EQJPF)) // operands fit
+				i += 1;
+			break;
+		}
+		default: ;
+		}
+	}
+}
+
+/// @return whether `ins` is a jump of U bycodes
+static bool is_jump(tins ins)
+{
+	return ins == OP_JPF || ins == OP_JPB || ins == OP_CJPFPOP || ins == OP_CJPBPOP;
+}
+
+/// @return location of the bycode the jump `cmd` at `i` goes to
+static uint_size_cmd jump_target(tbycode cmd, uint_size_cmd i)
+{
+	tins ins = cmd.ins();
+
+	if (ins == OP_JPF || ins == OP_CJPFPOP)
+		return i + cmd.get_U() + 1;
+	return i + 1 - cmd.get_U();
+}
+
+/// Make the jump `cmd` at `i` go to `target`, switching its direction if needed
+static void set_jump_target(tbycode & cmd, uint_size_cmd i, uint_size_cmd target)
+{
+	bool cond = cmd.ins() == OP_CJPFPOP || cmd.ins() == OP_CJPBPOP;
+
+	if (target > i)
+		cmd = tbycode(cond ? OP_CJPFPOP : OP_JPF, target - i - 1);
+	else
+		cmd = tbycode(cond ? OP_CJPBPOP : OP_JPB, i + 1 - target);
+}
+
+/** Mark the end of the innermost function body holding each bycode
+ *  @details The end of a body is the location of the bycode following it,
+ *  and is tcmds.size() for the bycodes out of any function body. Jumps never
+ *  leave their body but may go to its end, which returns from the function.
+ */
+static void body_ends(tvmcmd_vect & tcmds, std::vector<uint_size_cmd> & ends)
+{
+	uint_size_cmd ncmds = tcmds.size32();
+	std::vector<uint_size_cmd> bodies;
+	ends.resize(ncmds);
+
+	for (uint_size_cmd i = 0; i < ncmds; i++) {
+		while (!bodies.empty() && bodies.back() <= i)
+			bodies.pop_back();
+		ends[i] = bodies.empty() ? ncmds : bodies.back();
+
+		if (tcmds[i].ins() == OP_PUSHF)
+			bodies.push_back(i + tcmds[i].get_U() + 1);
+	}
+}
+
+/** Fold the constant operands `v1 op v2` of a binary operation
+ *  @details Follows the numerical operators of Tap VM: the result of integers
+ *  is an integer for +, -, * and /, and a double float otherwise. Integer
+ *  divisions by zero are left for the runtime error.
+ *  @param c1 - OP_PUSHI / OP_PUSHD of v1 (left operand)
+ *  @param c2 - OP_PUSHI / OP_PUSHD of v2 (right operand)
+ *  @param re - OP_PUSHI / OP_PUSHD of the result
+ *  @return whether the operation is folded
+ */
+static bool fold_binop(tins op, tbycode c1, tbycode c2, tconsts & consts, tbycode & re)
+{
+	bool int1 = c1.ins() == OP_PUSHI;
+	bool int2 = c2.ins() == OP_PUSHI;
+	long l1 = int1 ? consts.__intcsts[c1.get_U()] : 0;
+	long l2 = int2 ? consts.__intcsts[c2.get_U()] : 0;
+	double d1 = int1 ? static_cast<double>(l1) : consts.__dblcsts[c1.get_U()];
+	double d2 = int2 ? static_cast<double>(l2) : consts.__dblcsts[c2.get_U()];
+
+	if (int1 && int2 && op != OP_MOD && op != OP_POW) {
+		long l = 0;
+
+		switch (op) {
+		case OP_ADD: l = l1 + l2; break;
+		case OP_SUB: l = l1 - l2; break;
+		case OP_MUL: l = l1 * l2; break;
+		case OP_DIV:
+			if (l2 == 0)
+				return false;
+			l = l1 / l2;
+			break;
+		default: return false;
+		}
+		re = tbycode(OP_PUSHI, consts.add_int_const(l));
+		return true;
+	}
+	double d = 0;
+
+	switch (op) {
+	case OP_ADD: d = d1 + d2; break;
+	case OP_SUB: d = d1 - d2; break;
+	case OP_MUL: d = d1 * d2; break;
+	case OP_DIV: d = d1 / d2; break;
+	case OP_MOD: d = fmod(d1, d2); break;
+	case OP_POW: d = pow(d1, d2); break;
+	default: return false;
+	}
+	re = tbycode(OP_PUSHD, consts.add_double_const(d));
+	return true;
+}
+
+/** Fold the arithmetic operations on literal numbers (level 2)
+ *  @details The operands of OP_ADD ... OP_POW 0 1 vv are the last two values
+ *  pushed. If both are pushed by OP_PUSHI / OP_PUSHD and no jump goes between
+ *  them, the operation is folded into the push of its right operand (the
+ *  first pushed), and the rest becomes OP_PASS. Nested operations are folded
+ *  in the same scan, e.g. `1 + 2 * 3` into OP_PUSHI 7.
+ */
+void fold_consts(tvmcmd_vect & tcmds, tconsts & consts)
+{
+	uint_size_cmd ncmds = tcmds.size32();
+	std::vector<bool> targets(ncmds + 1, false);
+
+	for (uint_size_cmd i = 0; i < ncmds; i++) {
+		tins ins = tcmds[i].ins();
+
+		if (is_jump(ins))
+			targets[jump_target(tcmds[i], i)] = true;
+		else if (ins == OP_PUSHF)
+			targets[i + tcmds[i].get_U() + 1] = true;
+	}
+	std::vector<uint_size_cmd> pushes;  // literal numbers on the top of the stack
+
+	for (uint_size_cmd i = 0; i < ncmds; i++) {
+		tbycode & cmd = tcmds[i];
+		tins ins = cmd.ins();
+
+		if (targets[i])
+			pushes.clear();
+		if (ins == OP_PASS)
+			continue;
+		if (ins == OP_PUSHI || ins == OP_PUSHD) {
+			pushes.push_back(i);
+			continue;
+		}
+		uint_size_cmd n = static_cast<uint_size_cmd>(pushes.size());
+		tbycode re;
+
+		if (ins >= OP_ADD && ins <= OP_POW && ins != OP_MMUL && n >= 2
+		&& cmd.get_k() == BINOP_VV && cmd.get_Lk() == 0 && cmd.get_Rk() == 1
+		&& fold_binop(ins, tcmds[pushes[n - 1]], tcmds[pushes[n - 2]], consts, re)) {
+			tcmds[pushes[n - 2]] = re;
+			tcmds[pushes[n - 1]] = tbycode(OP_PASS);
+			cmd = tbycode(OP_PASS);
+			pushes.pop_back();
+		} else
+			pushes.clear();
+	}
+}
+
+/** Thread the jumps going to unconditional jumps (level 1)
+ *  @details OP_PASS on the way is skipped. Conditional jumps are only threaded
+ *  forwards, so that they can still be fused into OP_EQJPF ... OP_SLJPF.
+ */
+static void thread_jumps(tvmcmd_vect & tcmds, const std::vector<uint_size_cmd> & ends)
+{
+	uint_size_cmd ncmds = tcmds.size32();
+
+	for (uint_size_cmd i = 0; i < ncmds; i++) {
+		tins ins = tcmds[i].ins();
+
+		if (!is_jump(ins))
+			continue;
+		bool cond = ins == OP_CJPFPOP || ins == OP_CJPBPOP;
+		uint_size_cmd target = jump_target(tcmds[i], i);
+		uint_size_cmd t = target;
+
+		// bounded by ncmds against the loops of jumps
+		for (uint_size_cmd hops = 0; t < ends[i] && hops < ncmds; hops++) {
+			tins ins_t = tcmds[t].ins();
+
+			if (ins_t == OP_PASS)
+				t++;
+			else if (ins_t == OP_JPF || ins_t == OP_JPB) {
+				uint_size_cmd t_next = jump_target(tcmds[t], t);
+
+				if (cond && t_next <= i)
+					break;
+				t = t_next;
+				target = t;
+			} else
+				break;
+		}
+		set_jump_target(tcmds[i], i, target);
+	}
+}
+
+/** Mark the bycodes reachable from the entry of the program
+ *  @details The bodies of the functions are entered from their OP_PUSHF.
+ */
+static void reachable(tvmcmd_vect & tcmds, const std::vector<uint_size_cmd> & ends,
+		std::vector<bool> & live)
+{
+	uint_size_cmd ncmds = tcmds.size32();
+	std::vector<uint_size_cmd> todo;
+	live.assign(ncmds, false);
+
+	if (ncmds > 0)
+		todo.push_back(0);
+
+	while (!todo.empty()) {
+		uint_size_cmd i = todo.back();
+		todo.pop_back();
+
+		if (live[i])
+			continue;
+		live[i] = true;
+		uint_size_cmd end = ends[i];
+		uint_size_cmd next = i + 1;
+
+		switch (tcmds[i].ins()) {
+		case OP_RET:
+			continue;
+		case OP_JPF: case OP_JPB:
+			next = jump_target(tcmds[i], i);
+			break;
+		case OP_CJPFPOP: case OP_CJPBPOP:
+			if (jump_target(tcmds[i], i) < end)
+				todo.push_back(jump_target(tcmds[i], i));
+			break;
+		case OP_PUSHF:
+			if (tcmds[i].get_U() > 0)
+				todo.push_back(i + 1);
+			next = i + tcmds[i].get_U() + 1;
+			break;
+		default: ;
+		}
+		if (next < end)
+			todo.push_back(next);
+	}
+}
+
+/** Remove the bycodes not kept
+ *  @details Jumps and function bodies are re-encoded over the remaining
+ *  bycodes. A jump to a removed bycode goes to the next one kept.
+ */
+static void compact(tvmcmd_vect & tcmds, const std::vector<bool> & keep)
+{
+	uint_size_cmd ncmds = tcmds.size32();
+	std::vector<uint_size_cmd> newloc(ncmds + 1);
+	uint_size_cmd m = 0;
+
+	for (uint_size_cmd i = 0; i < ncmds; i++) {
+		newloc[i] = m;
+		if (keep[i])
+			m++;
+	}
+	newloc[ncmds] = m;
+	tvmcmd_vect kept;
+
+	for (uint_size_cmd i = 0; i < ncmds; i++) {
+		if (!keep[i])
+			continue;
+		tbycode cmd = tcmds[i];
+		tins ins = cmd.ins();
+
+		if (is_jump(ins))
+			set_jump_target(cmd, newloc[i], newloc[jump_target(cmd, i)]);
+		else if (ins == OP_PUSHF)
+			cmd = tbycode(OP_PUSHF, newloc[i + cmd.get_U() + 1] - newloc[i] - 1);
+		kept.push_back(cmd);
+	}
+	tcmds.swap(kept);
+}
+
+/** Simplify the control flow (level 1)
+ *  @details Threads jumps, then removes OP_PASS (left by if-elif-else and by
+ *  fold_consts), unconditional jumps to the next bycode and the unreachable
+ *  bycodes, e.g. those after OP_RET. Repeated until nothing is removed.
+ */
+void simplify_flow(tvmcmd_vect & tcmds)
+{
+	std::vector<uint_size_cmd> ends;
+	std::vector<bool> keep;
+
+	for (;;) {
+		body_ends(tcmds, ends);
+		thread_jumps(tcmds, ends);
+		reachable(tcmds, ends, keep);
+		bool removed = false;
+
+		for (uint_size_cmd i = 0; i < tcmds.size32(); i++) {
+			tins ins = tcmds[i].ins();
+
+			if (ins == OP_PASS || (ins == OP_JPF && tcmds[i].get_U() == 0))
+				keep[i] = false;
+			removed = removed || !keep[i];
+		}
+		if (!removed)
+			break;
+		compact(tcmds, keep);
+	}
+}
+
+/** Drop the constants no longer used by any bycode (level 1)
+ *  @details The constants kept are renumbered in the order of their first use.
+ */
+void shrink_consts(tvmcmd_vect & tcmds, tconsts & consts)
+{
+	tconsts used;
+
+	for (auto iter = tcmds.begin(); iter != tcmds.end(); iter++) {
+		tins ins = iter->ins();
+
+		switch (ins) {
+		case OP_PUSHI:
+			*iter = tbycode(ins, used.add_int_const(consts.__intcsts[iter->get_U()]));
+			break;
+		case OP_PUSHD:
+			*iter = tbycode(ins, used.add_double_const(consts.__dblcsts[iter->get_U()]));
+			break;
+		case OP_PUSHS: case OP_IMPORT:
+			*iter = tbycode(ins, used.add_str_const(consts.__strcsts[iter->get_U()]));
+			break;
+		case OP_VCRT: {
+			uint32_t nameloc = iter->get_C();
+
+			if (nameloc != UNDEF_NAMELOC)
+				nameloc = used.add_str_const(consts.__strcsts[nameloc]);
+			*iter = tbycode(ins, nameloc, iter->get_P());
+			break;
+		}
+		default: ;
+		}
+	}
+	consts = used;
+}
 
 twrapper * make_wrapper(tvmcmd_vect & tcmds, tconsts & consts, tcinfo & info)
 {
@@ -646,11 +1375,33 @@ twrapper * make_wrapper(tvmcmd_vect & tcmds, tconsts & consts, tcinfo & info)
 
 public:
 
-/// Do static analysis of bycodes and then make a wrapper
+/** @param superins - whether to fuse bycodes into superinstructions
+ *  @param optlevel - level of static optimization: 0 (none), 1 (control flow
+ *                    and constants pool) or 2 (1 and constant folding)
+ */
+tanalyser(bool superins = true, uint8_t optlevel = 0)
+{
+	__superins = superins;
+	__optlevel = optlevel;
+}
+
+/** Do static analysis of bycodes and then make a wrapper
+ *  @details The bycodes are relocated when optimized, so that `tcmds` must
+ *  be executed from its beginning (not the case of the interactive mode).
+ */
 twrapper * wrap(tvmcmd_vect & tcmds, tconsts & consts, tcinfo & info)
 {
-	/// TO DO SOME OPTIMIMIZATION ......
-	return make_wrapper(tcmds, consts, info);
+	if (__optlevel >= 2)
+		fold_consts(tcmds, consts);
+	if (__optlevel >= 1) {
+		simplify_flow(tcmds);
+		shrink_consts(tcmds, consts);
+	}
+	twrapper * wrapper = make_wrapper(tcmds, consts, info);
+
+	if (__superins)
+		fuse_superins(wrapper->cmdarr, wrapper->ncmds);
+	return wrapper;
 }
 
 /// Save wrapper onto hard disk
@@ -661,6 +1412,10 @@ void save_bin_file(const twrapper * wrapper, const std::string & file)
 	if (nullptr == f)
 		twarn(ErrSession_IO).warn("tanalyser::save_bin_file", "");
 
+	// write head: magic number and format version
+	const uint32_t head[2] = {Tapc_Magic, Tapc_Version};
+	fwrite(head, sizeof(uint32_t), 2, f);
+
 	// write 'wrapper'
 	fwrite(wrapper, sizeof (twrapper), 1, f);
 
@@ -695,11 +1450,25 @@ twrapper * load_bin_file(const std::string & file)
 		return nullptr;
 	}
 
+	// read head: magic number and format version
+	uint32_t head[2] = {0, 0};
+
+	if (2 != fread(head, sizeof(uint32_t), 2, binf) || head[0] != Tapc_Magic) {
+		fclose(binf);
+		twarn(ErrSession_IO).warn("tanalyser::load_bin_file", file + " is not a bycodes file");
+	}
+	if (head[1] != Tapc_Version) {
+		fclose(binf);
+		twarn(ErrSession_IO).warn("tanalyser::load_bin_file", file + " of old version, re-compile it");
+	}
+
 	// read 'wrapper'
 	twrapper * wrapper = new twrapper();
 
 	if (1 != fread(wrapper, sizeof(twrapper), 1, binf))
 		twarn(ErrSession_IO).warn("tanalyser::load_bin_file", "");
+	wrapper->nprotos = 0;
+	wrapper->protos = nullptr;
 
 	// read 'wrapper.cmdarr'
 	uint_size_cmd cmdlen = wrapper->ncmds;
@@ -768,9 +1537,52 @@ void clean_wrapper(twrapper * wrapper)
 		}
 		delete [] wrapper->consts.cstrs;
 	}
+	if (wrapper->protos != nullptr) {
+		for (uint_size_cmd i = 0; i < wrapper->nprotos; i++)
+			wrapper->protos[i]->ddc_refctr();
+		delete [] wrapper->protos;
+	}
 	delete wrapper;
 }
 
+/** Make the prototypes of the function literals of a wrapper to be executed
+ *  @details The first bycode of each OP_PUSHINFO x 4, OP_PUSHF sequence is
+ *  rewritten into OP_PUSHP, which creates the function from its prototype and
+ *  skips the rest of the sequence and the body. Done once for a wrapper: every
+ *  OP_PUSHF is rewritten so, a wrapper with one out of the sequence is invalid.
+ */
+void make_protos(twrapper * wrapper)
+{
+	if (wrapper->protos != nullptr)
+		return;
+	tbycode * cmdarr = wrapper->cmdarr;
+	std::vector<tproto *> protos;
+
+	for (uint_size_cmd i = 0; i < wrapper->ncmds; i++) {
+		if (cmdarr[i].ins() != OP_PUSHF)
+			continue;
+		if (i < 4 || cmdarr[i - 4].ins() != OP_PUSHINFO || cmdarr[i - 3].ins() != OP_PUSHINFO
+		|| cmdarr[i - 2].ins() != OP_PUSHINFO || cmdarr[i - 1].ins() != OP_PUSHINFO) {
+			for (tproto * proto : protos)
+				proto->ddc_refctr();
+			twarn(ErrCompile_Other).warn("tanalyser::make_protos", "OP_PUSHF without its infos");
+		}
+		tbycode * cmd = cmdarr + i - 4;
+		protos.push_back(new tproto {
+			i + 1, cmd[4].get_U(),
+			static_cast<uint_size_obj>(cmd[0].get_U()),
+			static_cast<uint_size_obj>(cmd[1].get_U()),
+			static_cast<uint_size_stk>(cmd[2].get_U()),
+			static_cast<uint_size_stk>(cmd[3].get_U()), 1 });
+		cmd[0] = tbycode(OP_PUSHP, static_cast<uint32_t>(protos.size() - 1));
+	}
+	if (protos.empty())
+		return;
+	wrapper->nprotos = static_cast<uint_size_cmd>(protos.size());
+	wrapper->protos = new tproto*[protos.size()];
+	std::copy(protos.begin(), protos.end(), wrapper->protos);
+}
+
 /// Display wrapper
 void display_wrapper(const twrapper * wrapper)
 {
@@ -7,37 +7,41 @@
 namespace tapas
 {
 
+/// Number of environments of a display kept in the environment itself
+#define Tap_DISPLAY_INLINE 4
+
 /// Abstract Environment, a tree structure which stores objects in runtime.
 class tcompo_env_abstract : public tobj_array
 {
 private:
 	tcompo_env_abstract * __father_env;       /// Environment as a Tree
 	uint_size_obj __loc_in_father_env;            /// Environment as a Tree
+	uint_size_obj __ndisplay;                     /// length of __display
+	tcompo_env_abstract ** __display;             /// Environments by hops: self, father, ...
+	tcompo_env_abstract * __display_in[Tap_DISPLAY_INLINE]; /// __display if short enough
 
 public:
 tcompo_env_abstract(uint_size_obj objlst_cap, tcompo_env_abstract * father_env) : tobj_array(objlst_cap)
 {
+	// `this` is new: it can not be in the tree above (no looping reference),
+	// nor among the objects of its father yet
 	__father_env = father_env;
-	__loc_in_father_env = 0;
-
-	// Env Tree: check looping reference
-	if (0 == self_not_in_tree_of(father_env))
-		twarn(ErrRuntime_LoopRef).warn("tcompo_env::tcompo_env", "");
+	__loc_in_father_env = father_env == nullptr ? 0 : father_env->get_objlst_len();
 
-	// Env Tree: get __loc_in_father_env
-	if (__father_env == nullptr)
-		return;
-	for (; __loc_in_father_env < father_env->get_objlst_len(); __loc_in_father_env++) {
-		tobj & vi = __father_env->tobj_array::get_obj(__loc_in_father_env);
+	// Env Tree: display of the environments above
+	__ndisplay = father_env == nullptr ? 1 : father_env->__ndisplay + 1;
+	__display = __ndisplay <= Tap_DISPLAY_INLINE ? __display_in : new tcompo_env_abstract *[__ndisplay];
+	__display[0] = this;
 
-		if (vi.get_type() != tcompo)
-			continue;
-		if (this == reinterpret_cast<tcompo_env_abstract *>(vi.get_v_tcompo()))
-			break;
-	}
+	if (father_env != nullptr)
+		std::copy(father_env->__display, father_env->__display + father_env->__ndisplay, __display + 1);
 }
 
-virtual ~tcompo_env_abstract() {}
+virtual ~tcompo_env_abstract()
+{
+	if (__display != __display_in)
+		delete [] __display;
+}
 
 /// @return the father environment
 tcompo_env_abstract * get_father_env()
@@ -48,11 +52,7 @@ tcompo_env_abstract * get_father_env()
 /// @return the top environment
 tcompo_env_abstract * get_top_env()
 {
-	tcompo_env_abstract * top = this;
-
-	while (nullptr != top->get_father_env())
-		top = top->get_father_env();
-	return top;
+	return __display[__ndisplay - 1];
 }
 
 /// @return the location of `this` object in father environment
@@ -108,6 +108,20 @@ void set_obj(uint_size_obj loc, const tobj & v, tcompo_env_abstract * from = nul
 	}
 }
 
+/** @return the object at `slot` of the environment `hops` levels above
+ *  @details (hops, slot) are resolved at compile time, see tobj_ctr::obj_slot
+ */
+tobj & get_obj_at(uint_size_obj hops, uint_size_obj slot)
+{
+	return __display[hops]->tobj_array::get_obj(slot);
+}
+
+/// Set the object at `slot` of the environment `hops` levels above
+void set_obj_at(uint_size_obj hops, uint_size_obj slot, const tobj & v)
+{
+	__display[hops]->tobj_array::set_obj(slot, v);
+}
+
 /// check 'env' is not in the tree of 'this'
 bool self_tree_has_no(tcompo_env_abstract * const env)
 {
@@ -131,6 +145,12 @@ bool self_not_in_tree_of(tcompo_env_abstract * const env)
 	return self_not_in_tree_of(env->get_father_env());
 }
 
+/// check 'env' is above 'this' in the tree (by the display)
+bool is_below(const tcompo_env_abstract * env) const
+{
+	return __ndisplay > env->__ndisplay && __display[__ndisplay - env->__ndisplay] == env;
+}
+
 };
 
 
@@ -138,7 +158,6 @@ bool self_not_in_tree_of(tcompo_env_abstract * const env)
 class tcompo_env : public tcompo_env_abstract
 {
 private:
-	tobj * __vmstack;                /// VM info
 	tobj * __params;                 /// VM info
 	uint_size_obj __tmpmax;              /// VM info
 	uint_size_stk __regmax;              /// VM info
@@ -152,7 +171,6 @@ tcompo_env(uint_size_obj objlst_cap, tcompo_env * father_env, uint_size_stk regm
 		uint_size_stk tmpmax, uint_size_stk nparams, tcompo_type compo_type)
 	: tcompo_env_abstract(objlst_cap, father_env)
 {
-	__vmstack = nullptr;
 	__params = nullptr;
 	__dynamic_nparams = 0;
 	set_tmpmax(tmpmax);
@@ -161,10 +179,7 @@ tcompo_env(uint_size_obj objlst_cap, tcompo_env * father_env, uint_size_stk regm
 	__compo_type = compo_type;
 }
 
-virtual ~tcompo_env()
-{
-	set_regmax(0);
-}
+virtual ~tcompo_env() {}
 
 /// @return a pointer to self
 virtual tcompo_env * get_self()
@@ -208,12 +223,6 @@ uint_size_stk get_regmax() const
 	return __regmax;
 }
 
-/// @return __vmstack (for VM)
-tobj * get_vmstack() const
-{
-	return __vmstack;
-}
-
 /// @return __tmpmax (for VM)
 uint_size_obj get_tmpmax() const
 {
@@ -242,13 +251,6 @@ void set_dynamic_nparams(uint_size_stk n)
 void set_regmax(uint_size_stk n)
 {
 	__regmax = n;
-
-	if (__vmstack) {
-		delete [] __vmstack;
-		__vmstack = nullptr;
-	}
-	if (n > 0)
-		__vmstack = new tobj[n];
 }
 
 /// Set __tmpmax (for VM)
@@ -278,6 +280,8 @@ private:
 	const char * __name;
 
 public:
+Tap_COMPO_ALLOC(compo_sessfunc)
+
 tcppsessf(const sessf & f, const char * name)
 {
 	__f = f;
@@ -343,24 +347,75 @@ const char * get_name() const
 };
 
 
-/// User Defined Functions in Tap
+/** User Defined Functions in Tap
+ *  @details A function is a closure: its prototype (shared, immutable) and the
+ *  environment where it is created.
+ */
 class tfunc : public tcompo_v, public tcompo_env
 {
 private:
-	uint_size_cmd __cmdloc;
-	uint_size_cmd __ncmds;
+	tproto      * __proto;   /// prototype
+	tcompo_env  * __lib;     /// top environment (library)
+	uint32_t      __nactive; /// number of running activations
+	tfunc       * __act;     /// activation where this function is created, referred
+	bool          __activation; /// environment of a single activation
+	bool          __captured;   /// functions are created in this environment
+
+/// Drop the reference to the activation where this function is created
+void drop_act()
+{
+	if (__act != nullptr && __act->ddc_refctr() == 0)
+		__act->release();
+	__act = nullptr;
+}
 
 public:
-tfunc(uint_size_obj nlocals, tcompo_env * father_env, uint_size_stk reg_max,
-		uint_size_obj tmpmax, uint_size_stk nparams,
-		uint_size_cmd cmdloc, uint_size_cmd ncmds)
-	: tcompo_env(nlocals, father_env, reg_max, tmpmax, nparams, compo_tfunc)
+Tap_COMPO_ALLOC(compo_tfunc)
+
+tfunc(tproto * proto, tcompo_env * father_env)
+	: tcompo_env(proto->nobjs, father_env, proto->regmax, proto->ntmps, proto->nparams, compo_tfunc)
+{
+	__proto  = proto;
+	__proto->add_refctr();
+	__lib    = static_cast<tcompo_env *>(get_top_env());
+	__nactive = 0;
+	__act = nullptr;
+	__activation = false;
+	__captured = false;
+
+	// an activation is freed once left, unless its functions refer it
+	if (father_env != nullptr && father_env->tenv_get_compo_type() == compo_tfunc) {
+		tfunc * father = static_cast<tfunc *>(father_env);
+
+		father->__captured = true;
+		if (father->__activation) {
+			__act = father;
+			__act->add_refctr();
+		}
+	}
+	gc_track();
+}
+
+~tfunc()
+{
+	__proto->ddc_refctr();
+	drop_act();
+}
+
+/// Visit the objects kept by the function (see tgc)
+void gc_traverse(tgc_visitf f, void * arg)
 {
-	__cmdloc = cmdloc;
-	__ncmds  = ncmds;
+	traverse_objs(f, arg);
+	if (__act != nullptr)
+		f(__act, arg);
 }
 
-~tfunc() {}
+/// Drop the objects kept by the function (see tgc)
+void gc_clear()
+{
+	clear_objs();
+	drop_act();
+}
 
 /// Assign `params` to the object array of this environment
 void assign_params(tobj * const params, uint_size_stk nparams)
@@ -382,13 +437,57 @@ void assign_params(tobj * const params, uint_size_stk nparams)
 /// @return the location of the command of this function in bycode list
 uint_size_cmd get_cmdloc() const
 {
-	return __cmdloc;
+	return __proto->cmdloc;
 }
 
 /// @return number of commands
 uint_size_cmd get_ncmds() const
 {
-	return __ncmds;
+	return __proto->ncmds;
+}
+
+/// @return the library where this function is defined
+tcompo_env * get_lib() const
+{
+	return __lib;
+}
+
+/// @return the number of running activations of this function
+uint32_t get_nactive() const
+{
+	return __nactive;
+}
+
+/// Mark that an activation of this function starts running
+void activate()
+{
+	__nactive++;
+}
+
+/// Mark that an activation of this function stops running
+void deactivate()
+{
+	__nactive--;
+}
+
+/// Make `this` the environment of a single activation (see tvm::enter_tfunc),
+/// freed once left unless the functions created in it refer it
+void set_activation()
+{
+	__activation = true;
+}
+
+/// @return whether `this` is the environment of a single activation
+bool is_activation() const
+{
+	return __activation;
+}
+
+/// @return whether functions are created in this environment, which may
+/// read its objects later
+bool is_captured() const
+{
+	return __captured;
 }
 
 /// @return a brief string of this object
@@ -406,9 +505,7 @@ std::string tostring_full() const
 /// @return a copy of this object
 tfunc * copy()
 {
-	return new tfunc(get_objlst_cap(), get_father_env(), get_regmax(),
-				get_tmpmax(), get_nparams(),
-				get_cmdloc(), get_ncmds());
+	return new tfunc(__proto, get_father_env());
 }
 
 /// @return a pointer to self
@@ -452,6 +549,133 @@ private:
 	std::vector<std::string> __paths;           /// searching path
 	twrapper               * __wrapper;         /// wrapper
 	tdict                  * __exposed;         /// exposed dict
+	std::vector<tkeycache>   __keycaches;       /// lookups of constant keys by the wrapper
+	std::vector<tshape *>    __shapes;          /// shapes of the records by the wrapper
+	std::vector<tstr *>      __cstrs;           /// interned constant strings of the wrapper
+
+/** Give the indexing by constant keys of the wrapper their lookup caches
+ *  @details `obj::key` is compiled into OP_PUSHS key, OP_PUSHX obj, OP_IDXR 1
+ *  and `obj['key'] = v` into (v), OP_PUSHS key, OP_IDXL obj 1. The first
+ *  bycode is rewritten into OP_PUSHK or OP_IDXLK, which do the whole
+ *  sequence on dicts and records through the cache.
+ *  Each OP_PUSHREC is rewritten into OP_PUSHRECS with the shape of its keys,
+ *  shared by all the records literals of the same keys.
+ *  An OP_PUSHS whose string is only read by the next bycode (see reads_top)
+ *  is rewritten into OP_PUSHSC, pushing the interned string instead of a
+ *  new one.
+ */
+void bind_keys()
+{
+	tbycode * cmdarr = __wrapper->cmdarr;
+	uint_size_cmd ncmds = __wrapper->ncmds;
+
+	__keycaches.clear();
+	rm_shapes();
+	rm_cstrs();
+	__cstrs.resize(__wrapper->consts.ncstrs, nullptr);
+	for (uint_size_cmd i = 0; i + 1 < ncmds; i++) {
+		tbycode * cmd = cmdarr + i;
+
+		if (cmd->ins() == OP_PUSHREC) {
+			i += cmd->get_U(); // keys not bound
+			bind_shape(cmd);
+			continue;
+		}
+		if (cmd->ins() != OP_PUSHS)
+			continue;
+		uint_size_cst name = cmd->get_U();
+
+		if (reads_top(cmd[1])) {
+			*cmd = tbycode(OP_PUSHSC, static_cast<uint32_t>(name));
+			intern(name);
+			continue;
+		}
+		if (__keycaches.size() > Limit_U_N) // beyond the parameter of OP_PUSHK
+			continue;
+		if (cmd[1].ins() == OP_PUSHX && i + 2 < ncmds && cmd[2].ins() == OP_IDXR && cmd[2].get_U() == 1)
+			*cmd = tbycode(OP_PUSHK, static_cast<uint32_t>(__keycaches.size()));
+		else if (cmd[1].ins() == OP_IDXL && cmd[1].get_b() == 1)
+			*cmd = tbycode(OP_IDXLK, static_cast<uint32_t>(__keycaches.size()));
+		else
+			continue;
+		__keycaches.push_back({ name, nullptr, 0, nullptr, 0 });
+		intern(name); // key of the generic indexing
+	}
+}
+
+/** @return whether `cmd` only reads the value on stack top, without keeping
+ *  it: the comparisons with a side on stack top, and `in` (the element)
+ */
+static bool reads_top(tbycode & cmd)
+{
+	switch (cmd.ins()) {
+	case OP_EQ:    case OP_NE:    case OP_GE:    case OP_SG:
+	case OP_LE:    case OP_SL:    case OP_EQJPF: case OP_NEJPF:
+	case OP_GEJPF: case OP_SGJPF: case OP_LEJPF: case OP_SLJPF:
+		switch (cmd.get_k()) {
+		case BINOP_VV: case BINOP_EV: case BINOP_VE: case BINOP_TV: case BINOP_VT:
+			return true;
+		default:
+			return false;
+		}
+	case OP_IN:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/** Intern the constant string `k` of the wrapper
+ *  @details The string is made once, and kept by the library (its reference
+ *  counter never drops to 0) until the wrapper is removed. It is pushed only
+ *  where it is read without being kept or changed, so it is never changed.
+ */
+void intern(uint_size_cst k)
+{
+	if (__cstrs[k] != nullptr)
+		return;
+	__cstrs[k] = new tstr(__wrapper->consts.cstrs[k]);
+	__cstrs[k]->add_refctr();
+}
+
+/// Release the interned strings (kept by the values still refering to them)
+void rm_cstrs()
+{
+	for (auto iter = __cstrs.begin(); iter != __cstrs.end(); iter++) {
+		if (*iter == nullptr)
+			continue;
+		if ((*iter)->ddc_refctr() == 0)
+			(*iter)->release();
+	}
+	__cstrs.clear();
+}
+
+/// Rewrite OP_PUSHREC `cmd` into OP_PUSHRECS with the shape of its keys
+void bind_shape(tbycode * cmd)
+{
+	std::vector<std::string> keys;
+	uint_size_cmd ishape = 0;
+
+	for (uint_size_cmd k = 1; k <= cmd->get_U(); k++)
+		keys.push_back(__wrapper->consts.cstrs[cmd[k].get_U()]);
+	while (ishape < __shapes.size() && __shapes[ishape]->get_keys() != keys)
+		ishape++;
+	if (ishape > Limit_U_N) // beyond the parameter of OP_PUSHRECS: not bound
+		return;
+	if (ishape == __shapes.size()) {
+		__shapes.push_back(new tshape(keys));
+		__shapes.back()->add_refctr();
+	}
+	*cmd = tbycode(OP_PUSHRECS, static_cast<uint32_t>(ishape));
+}
+
+/// Release the shapes of the wrapper (kept by the records still alive)
+void rm_shapes()
+{
+	for (auto iter = __shapes.begin(); iter != __shapes.end(); iter++)
+		(*iter)->ddc_refctr();
+	__shapes.clear();
+}
 
 /// Remove wrapper from the library
 void rm_wrapper()
@@ -459,13 +683,18 @@ void rm_wrapper()
 	if (nullptr != __wrapper)
 		tanalyser().clean_wrapper(__wrapper);
 	__wrapper = nullptr;
+	rm_shapes();
+	rm_cstrs();
 	set_tmpmax(0);
 	set_regmax(0);
 }
 
 public:
+Tap_COMPO_ALLOC(compo_tlib)
+
 tlib() : tcompo_env(0, nullptr, 0, 0, 0, compo_tlib)
 {
+	keep_names();
 	__wrapper = nullptr;
 	__exposed = nullptr;
 }
@@ -473,8 +702,10 @@ tlib() : tcompo_env(0, nullptr, 0, 0, 0, compo_tlib)
 ~tlib()
 {
 	rm_wrapper();
-	if (__exposed != nullptr)
-		delete __exposed;
+	if (__exposed != nullptr) {
+		if (__exposed->ddc_refctr() == 0)
+			__exposed->release();
+	}
 }
 
 /// Add wrapper to the library
@@ -483,11 +714,31 @@ void set_wrapper(twrapper * wrapper)
 	if (nullptr != __wrapper)
 		rm_wrapper();
 	__wrapper = wrapper;
+	tanalyser().make_protos(wrapper);
+	bind_keys();
 	try_expand_objlist(wrapper->info.obj_max);
 	set_tmpmax(wrapper->info.tmp_max);
 	set_regmax(wrapper->info.reg_max);
 }
 
+/// @return the cache of the lookup of a constant key `k`, see bind_keys
+tkeycache & get_keycache(uint_size_cmd k)
+{
+	return __keycaches[k];
+}
+
+/// @return the interned constant string `k` of the wrapper, see bind_keys
+tstr * get_cstr(uint_size_cst k)
+{
+	return __cstrs[k];
+}
+
+/// @return the shape of the records made by OP_PUSHRECS `k`, see bind_keys
+tshape * get_shape(uint_size_cmd k)
+{
+	return __shapes[k];
+}
+
 /// Add object `v` named by `name` to the library
 void lib_add_obj(const std::string & name, const tobj & v)
 {
@@ -540,10 +791,12 @@ tdict * get_exposed()
 	return __exposed;
 }
 
-/// Set the objects that is exposed to outside and indexable
+/// Set the objects that is exposed to outside and indexable, referred by
+/// the library until it is destroyed
 void set_exposed(tdict * v)
 {
 	__exposed = v;
+	__exposed->add_refctr();
 }
 
 /// lib::object - Get the object from library
@@ -634,9 +887,8 @@ tlist * listing_objects()
 		idx ++;
 	}
 	for (uint_size_obj idx = __default_v_names.size(); idx < get_objlst_len(); idx++) {
-		tobj vi = get_obj(idx);
 		std::string name;
-		name += std::string(__wrapper->consts.cstrs[vi.get_name_loc()]);
+		name += std::string(__wrapper->consts.cstrs[get_name_loc(idx)]);
 		tobj v(new tstr(name));
 		ls->set_append(&v);
 	}
@@ -1,4 +1,4 @@
-#ifndef TPARSER_H
+﻿#ifndef TPARSER_H
 #define TPARSER_H
 
 #include "tbasis.h"
@@ -175,6 +175,30 @@ uint_size_obj obj_loc(const std::string & objname)
 	return loc;
 }
 
+/** Searching from local environment, like obj_loc, for the address of
+ *  `objname` in the environment where it is found.
+ *  @param hops - set to the number of father environments to go up
+ *  @return loc in the environment found
+ */
+uint_size_obj obj_slot(const std::string & objname, uint_size_obj & hops)
+{
+	tobj_ctr * ctr = this;
+	hops = 0;
+
+	while (true) {
+		uint_size_obj loc = 0;
+
+		for (auto iter = ctr->__objs.cbegin(); iter != ctr->__objs.cend(); iter++) {
+			if (*iter == objname) break;
+			loc++;
+		}
+		if (!ctr->__father || loc < ctr->__objs.size())
+			return loc;
+		ctr = ctr->__father;
+		hops++;
+	}
+}
+
 /// @return locotion of `left`
 uint_size_obj obj_create(const std::string & left, bool inblk, tconsts & consts, uint_size_cst & nameloc)
 {
@@ -226,7 +250,7 @@ struct tbin_expr
 {
 	std::string left;      ///< **std::string** of left
 	std::string right;     ///< **std::string** of right
-	uint8_t     al_type;   ///< 0 1 2 or 3
+	tbinop_layout al_type; ///< operands layout
 	uint_size_obj   lloc;      ///< left object's loc in object list
 	uint_size_obj   rloc;      ///< right object's loc in object list
 };
@@ -242,6 +266,9 @@ private:
 	tstk_ctr  __regctr;          ///< register counter
 	uint_size_obj __n_default_objs;  ///< (preload) default objects
 	bool      __interactive;     ///< UI
+	bool      __superins;        ///< fuse bycodes into superinstructions
+	uint8_t   __optlevel;        ///< level of static optimization (0 - 2)
+	std::vector<uint_size_obj> __loops;  ///< temporary objects at the start of enclosing loop bodies
 
 bool find_imported_file(std::string & file, std::vector<std::string> & paths)
 {
@@ -312,13 +339,30 @@ void parse_v(const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts)
 			tcmds.append(tbycode(OP_PUSHX, loc_tmp, 0));
 			__regctr.add_stk_ctr();
 		} else if (loc_env < __objctr.obj_len_in_all()) {
-			tcmds.append(tbycode(OP_PUSHX, loc_env, 1));
+			uint_size_obj hops = 0;
+			uint_size_obj slot = __objctr.obj_slot(tok.value_1, hops);
+			tcmds.append(tbycode(OP_PUSHX, slot, uint16_t(hops + 1)));
 			__regctr.add_stk_ctr();
 		} else
 			twarn(ErrCompile_InvalidLiter).warn("tcp::parse_v", tok.value_1);
 	}
 }
 
+/** Address the environmental object `name` in LRk bycodes
+ *  @param loc - set to ENVLOC_LRk of `name`
+ *  @return false if `name` is out of the range of LRk bycodes
+ */
+bool binop_envloc(const std::string & name, uint_size_obj & loc)
+{
+	uint_size_obj hops = 0;
+	uint_size_obj slot = __objctr.obj_slot(name, hops);
+
+	if (slot >> ENVLOC_SLOT_BITS || ENVLOC_LRk(hops, 0) > Limit_LRk)
+		return false;
+	loc = ENVLOC_LRk(hops, slot);
+	return true;
+}
+
 /// Split 'cmd' and generate a 'tbin_expr'
 tbin_expr binop_split(const ttoken & toc)
 {
@@ -331,51 +375,59 @@ tbin_expr binop_split(const ttoken & toc)
 	uint_size_obj tmp_right_loc = __tmpctr.obj_loc(expr.right);
 	uint_size_obj obj_size_all = __objctr.obj_len_in_all();
 	uint_size_obj tmp_size_all = __tmpctr.obj_len_in_all();
-	expr.al_type = 0; // value value
+	expr.al_type = BINOP_VV;
+
+	// objects out of the range of LRk bycodes are pushed as values
+	bool left_env = obj_left_loc < obj_size_all && binop_envloc(expr.left, obj_left_loc);
+	bool left_tmp = tmp_left_loc < tmp_size_all && tmp_left_loc <= Limit_LRk;
+	bool left_v = !left_env && !left_tmp;
+	bool right_env = obj_right_loc < obj_size_all && binop_envloc(expr.right, obj_right_loc);
+	bool right_tmp = tmp_right_loc < tmp_size_all && tmp_right_loc <= Limit_LRk;
+	bool right_v = !right_env && !right_tmp;
 
 	// type 1: env value
-	if (obj_left_loc < obj_size_all && tmp_right_loc == tmp_size_all && obj_right_loc == obj_size_all) {
+	if (left_env && right_v) {
 		expr.lloc = obj_left_loc;
-		expr.al_type = 1;
+		expr.al_type = BINOP_EV;
 	}
 	// type 2: value env
-	if (tmp_left_loc == tmp_size_all && obj_left_loc == obj_size_all && obj_right_loc < obj_size_all) {
+	if (left_v && right_env) {
 		expr.rloc = obj_right_loc;
-		expr.al_type = 2;
+		expr.al_type = BINOP_VE;
 	}
 	// type 3: env env
-	if (obj_left_loc < obj_size_all && obj_right_loc < obj_size_all) {
+	if (left_env && right_env) {
 		expr.lloc = obj_left_loc;
 		expr.rloc = obj_right_loc;
-		expr.al_type = 3;
+		expr.al_type = BINOP_EE;
 	}
 	// type 4: tmp value
-	if (tmp_left_loc < tmp_size_all && tmp_right_loc == tmp_size_all && obj_right_loc == obj_size_all) {
+	if (left_tmp && right_v) {
 		expr.lloc = tmp_left_loc;
-		expr.al_type = 4;
+		expr.al_type = BINOP_TV;
 	}
 	// type 5: value tmp
-	if (tmp_left_loc == tmp_size_all && obj_left_loc == obj_size_all && tmp_right_loc < tmp_size_all) {
+	if (left_v && right_tmp) {
 		expr.rloc = tmp_right_loc;
-		expr.al_type = 5;
+		expr.al_type = BINOP_VT;
 	}
 	// type 6: tmp tmp
-	if (tmp_left_loc < tmp_size_all && tmp_right_loc < tmp_size_all) {
+	if (left_tmp && right_tmp) {
 		expr.lloc = tmp_left_loc;
 		expr.rloc = tmp_right_loc;
-		expr.al_type = 6;
+		expr.al_type = BINOP_TT;
 	}
 	// type 7: env tmp
-	if (obj_left_loc < obj_size_all && tmp_right_loc < tmp_size_all) {
+	if (left_env && right_tmp) {
 		expr.lloc = obj_left_loc;
 		expr.rloc = tmp_right_loc;
-		expr.al_type = 7;
+		expr.al_type = BINOP_ET;
 	}
 	// type 8: tmp env
-	if (tmp_left_loc < tmp_size_all && obj_right_loc < obj_size_all) {
+	if (left_tmp && right_env) {
 		expr.lloc = tmp_left_loc;
 		expr.rloc = obj_right_loc;
-		expr.al_type = 8;
+		expr.al_type = BINOP_TE;
 	}
 	return expr;
 }
@@ -385,69 +437,27 @@ void parse_binop(tins ins, const tbin_expr & expr, tvmcmd_vect & tcmds, tconsts
 		std::vector<std::string> & paths, bool inblk)
 {
 	switch (expr.al_type) {
-	case 0: // value value
+	case BINOP_VV:
 		parse_unit(expr.right, tcmds, consts, paths, 0, inblk);
 		parse_unit(expr.left, tcmds, consts, paths, 0, inblk);
-		tcmds.append(tbycode(OP_PUSHINFO, expr.al_type));
-		__regctr.add_stk_ctr(); // push info
-		tcmds.append(tbycode(ins, uint16_t(0), uint16_t(1)));
-		__regctr.ddt_stk_ctr(); // pop info
+		tcmds.append(tbycode(ins, uint16_t(0), uint16_t(1), expr.al_type));
 		__regctr.ddt_stk_ctr(); // pop top
 		break;
-	case 1: // env value
+	case BINOP_EV:
+	case BINOP_TV:
 		parse_unit(expr.right, tcmds, consts, paths, 0, inblk);
-		tcmds.append(tbycode(OP_PUSHINFO, expr.al_type));
-		__regctr.add_stk_ctr(); // push info
-		tcmds.append(tbycode(ins, expr.lloc, 0));
-		__regctr.ddt_stk_ctr(); // pop info
+		tcmds.append(tbycode(ins, expr.lloc, uint16_t(0), expr.al_type));
 		break;
-	case 2: // value env
+	case BINOP_VE:
+	case BINOP_VT:
 		parse_unit(expr.left, tcmds, consts, paths, 0, inblk);
-		tcmds.append(tbycode(OP_PUSHINFO, expr.al_type));
-		__regctr.add_stk_ctr(); // push info
-		tcmds.append(tbycode(ins, 0, expr.rloc));
-		__regctr.ddt_stk_ctr(); // pop info
+		tcmds.append(tbycode(ins, uint16_t(0), expr.rloc, expr.al_type));
 		break;
-	case 3: // env env
-		tcmds.append(tbycode(OP_PUSHINFO, expr.al_type));
-		__regctr.add_stk_ctr(); // push info
-		tcmds.append(tbycode(ins, expr.lloc, expr.rloc));
-		__regctr.ddt_stk_ctr(); // pop info
-		__regctr.add_stk_ctr(); // push return
-		break;
-	case 4: // tmp value
-		parse_unit(expr.right, tcmds, consts, paths, 0, inblk);
-		tcmds.append(tbycode(OP_PUSHINFO, expr.al_type));
-		__regctr.add_stk_ctr(); // push info
-		tcmds.append(tbycode(ins, expr.lloc, 0));
-		__regctr.ddt_stk_ctr(); // pop info
-		break;
-	case 5: // value tmp
-		parse_unit(expr.left, tcmds, consts, paths, 0, inblk);
-		tcmds.append(tbycode(OP_PUSHINFO, expr.al_type));
-		__regctr.add_stk_ctr(); // push info
-		tcmds.append(tbycode(ins, 0, expr.rloc));
-		__regctr.ddt_stk_ctr(); // pop info
-		break;
-	case 6: // tmp tmp
-		tcmds.append(tbycode(OP_PUSHINFO, expr.al_type));
-		__regctr.add_stk_ctr(); // push info
-		tcmds.append(tbycode(ins, expr.lloc, expr.rloc));
-		__regctr.ddt_stk_ctr(); // pop info
-		__regctr.add_stk_ctr(); // push return
-		break;
-	case 7: // env tmp
-		tcmds.append(tbycode(OP_PUSHINFO, expr.al_type));
-		__regctr.add_stk_ctr(); // push info
-		tcmds.append(tbycode(ins, expr.lloc, expr.rloc));
-		__regctr.ddt_stk_ctr(); // pop info
-		__regctr.add_stk_ctr(); // push return
-		break;
-	case 8: // tmp env
-		tcmds.append(tbycode(OP_PUSHINFO, expr.al_type));
-		__regctr.add_stk_ctr(); // push info
-		tcmds.append(tbycode(ins, expr.lloc, expr.rloc));
-		__regctr.ddt_stk_ctr(); // pop info
+	case BINOP_EE:
+	case BINOP_TT:
+	case BINOP_ET:
+	case BINOP_TE:
+		tcmds.append(tbycode(ins, expr.lloc, expr.rloc, expr.al_type));
 		__regctr.add_stk_ctr(); // push return
 		break;
 	}
@@ -478,6 +488,10 @@ void parse_binop(tins ins, const ttoken & tok, tvmcmd_vect & tcmds, tconsts & co
  *                execute `value`, then do Case 1.
  *      Case 2.2: If `value` is a variable, then throw a Compilation
  *                error `ErrCompile_ReturnTmpObj`.
+ *  Case 3: If `value` ends with a function call, e.g. `return f(x)` or
+ *      `return this(x)`, the call is a tail call (OP_TEVAL): the called
+ *      function runs on the frame of the returning one (unless it is
+ *      defined in the returning one, see OP_TEVAL).
  */
 void parse_return(const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts,
 		std::vector<std::string> & paths, bool inblk)
@@ -485,7 +499,12 @@ void parse_return(const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts,
 	if (tok.nval == 1) {
 		if (__tmpctr.obj_loc(tok.value_1) != __tmpctr.obj_len_in_all())
 			twarn(ErrCompile_ReturnTmpObj).warn("tvm::parse_return", "");
+		uint_size_cmd n = tcmds.size32();
 		parse_unit(tok.value_1, tcmds, consts, paths, 0, inblk);
+
+		// proper tail call: `value` ends with a function call
+		if (tcmds.size32() > n && tcmds.back().ins() == OP_EVAL)
+			tcmds.back().set_ins(OP_TEVAL);
 	}
 	tcmds.append(tbycode(OP_RET));
 	__regctr.ddt_stk_ctr_n(__regctr.get_stk_ctr());
@@ -590,6 +609,8 @@ void parse_import(const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts,
 	if (!find_imported_file(file, paths))
 		twarn(ErrCompile_UnfoundFile).warn("tcp::parse_import", tok.value_1);
 	tcp comp(__objctr.first_n_objs(__n_default_objs), nullptr);
+	comp.set_superins(__superins);
+	comp.set_optlevel(__optlevel);
 	comp.compile_file(file, paths);
 
 	if (tok.nval ==2) {
@@ -610,6 +631,37 @@ void parse_import(const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts,
 	}
 }
 
+/** Parse break/continue statement
+ *  @details Temporary variables created in the loop body are deleted, then
+ *           placeholder `ins` is emitted and later resolved to a relative
+ *           jump by the enclosing while/for statement.
+ */
+void parse_loopjump(tins ins, tvmcmd_vect & tcmds, const std::string & info)
+{
+	if (__loops.size() == 0)
+		twarn(ErrCompile_OutOfLoop).warn("tcp::parse_loopjump", info);
+	uint_size_obj newtmps = __tmpctr.obj_len_in_all() - __loops.back();
+
+	if (newtmps > 0)
+		tcmds.append(tbycode(OP_TMPDEL, newtmps));
+	tcmds.append(tbycode(ins));
+}
+
+/** Resolve OP_BREAK/OP_CONTI in the bycodes of a loop body
+ *  @details Those of nested loops are already resolved.
+ *  @param brk_n    OP_JPF parameter of an OP_BREAK at the beginning of body
+ *  @param conti_n  OP_JPB parameter of an OP_CONTI at the beginning of body
+ */
+void patch_loop_jumps(tvmcmd_vect & tcmds_blk, uint_size_cmd brk_n, uint_size_cmd conti_n)
+{
+	for (uint_size_cmd i = 0; i < tcmds_blk.size32(); i++) {
+		if (tcmds_blk[i].ins() == OP_BREAK)
+			tcmds_blk[i] = tbycode(OP_JPF, brk_n - i);
+		else if (tcmds_blk[i].ins() == OP_CONTI)
+			tcmds_blk[i] = tbycode(OP_JPB, conti_n + i);
+	}
+}
+
 /** Parse while statement
  */
 void parse_while (const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts, std::vector<std::string> & paths)
@@ -620,7 +672,18 @@ void parse_while (const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts, std
 	// Parse blk_s
 	parse_unit(tok.value_1, tcmds, consts, paths, 0, 1);
 	__regctr.ddt_stk_ctr(); // this is for the CJPFPOP ins below
-	parse_blk(tok.value_2, tcmds_blk, consts, paths, 1, 1);
+	__loops.push_back(__tmpctr.obj_len_in_all());
+
+	try {
+		parse_blk(tok.value_2, tcmds_blk, consts, paths, 1, 1);
+	} catch(...) {
+		__loops.pop_back();
+		throw;
+	}
+	__loops.pop_back();
+
+	// Break: jump after OP_JPB; Continue: jump back to the condition
+	patch_loop_jumps(tcmds_blk, tcmds_blk.size32(), tcmds.size32() - ncmds_ori + 2);
 
 	// Conditional Jump Forward
 	uint_size_cmd cjpfpop_n = tcmds_blk.size32() + 1;
@@ -639,11 +702,23 @@ void parse_for (const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts,
 {
 	// Define bycode vector
 	tvmcmd_vect tcmds_blk;
-	// Compile Right Part of 'in' Condition
-	parse_unit(tok.value_2, tcmds, consts, paths, 0, inblk);
+	// Compile Right Part of 'in' Condition: a range `start to end` is
+	// counted on stack (OP_FORPREP, OP_FORLOOP) instead of by an iterator
+	std::string range = tok.value_2;
+	std::vector<ttoken> rtokens;
+	tunit_splitter().preprocessing(range);
+	get_tokens(range, rtokens);
+	bool counted = rtokens.size() == 1 && rtokens[0].type == token_to;
+
+	if (counted) {
+		parse_unit(rtokens[0].value_2, tcmds, consts, paths, 0, inblk);
+		parse_unit(rtokens[0].value_1, tcmds, consts, paths, 0, inblk);
+		tcmds.append(tbycode(OP_FORPREP));
+	} else
+		parse_unit(tok.value_2, tcmds, consts, paths, 0, inblk);
 	// Find element var loc
 	uint_size_obj loc = 0;
-	bool isenv = false;
+	uint_size_obj ienv = 0;
 	uint_size_obj loc_left = __objctr.obj_loc(tok.value_1);
 	uint_size_obj tmp_left = __tmpctr.obj_loc(tok.value_1);
 	uint_size_obj nobjs = __objctr.obj_len_in_current_env();
@@ -652,8 +727,8 @@ void parse_for (const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts,
 	if (tmp_left != __tmpctr.obj_len_in_all())
 		loc = tmp_left;
 	else if (loc_left != __objctr.obj_len_in_all()) {
-		loc = loc_left;
-		isenv = true;
+		loc = __objctr.obj_slot(tok.value_1, ienv);
+		ienv++;
 	} else {
 		parse_unit(tok.value_1, tcmds, consts, paths, cleanstk, inblk);
 		// In loop declaration of environmental variable is NOT allowed
@@ -666,21 +741,31 @@ void parse_for (const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts,
 	}
 
 	// Prepare Loop Assignment
-	tcmds.append(tbycode(OP_LOOPAS, loc, isenv));
+	tcmds.append(tbycode(counted ? OP_FORLOOP : OP_LOOPAS, loc, ienv));
 	__regctr.add_stk_ctr();
 
 	// Compile Block
 	__regctr.ddt_stk_ctr();
+	__loops.push_back(__tmpctr.obj_len_in_all());
 
 	try {
-		parse_blk(tok.value_3, tcmds_blk, consts, paths, 1, 1);
+		try {
+			parse_blk(tok.value_3, tcmds_blk, consts, paths, 1, 1);
+		} catch(...) {
+			__loops.pop_back();
+			throw;
+		}
+		__loops.pop_back();
+		// Break: jump to OP_POPN after OP_JPB; Continue: jump back to OP_LOOPAS
+		// (or OP_FORLOOP)
+		patch_loop_jumps(tcmds_blk, tcmds_blk.size32(), 3);
 		uint_size_cmd cjpfpop_n = 1 + tcmds_blk.size32();
 		tcmds.append(tbycode(OP_CJPFPOP, cjpfpop_n));
 		tcmds.insert(tcmds.end(), tcmds_blk.begin(), tcmds_blk.end());
 		uint_size_cmd jpb_n = 3 + tcmds_blk.size32();
 		tcmds.append(tbycode(OP_JPB, jpb_n));
-		tcmds.append(tbycode(OP_POPN, uint16_t(1), uint16_t(0)));
-		__regctr.ddt_stk_ctr();
+		tcmds.append(tbycode(OP_POPN, uint16_t(counted ? 2 : 1), uint16_t(0)));
+		__regctr.ddt_stk_ctr_n(counted ? 2 : 1);
 		uint_size_obj newtmps = __tmpctr.obj_len_in_current_env() - ntmps;
 
 		// Delete temporary variables if there is any declare in for statement
@@ -776,20 +861,20 @@ void parse_asg(const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts, std::v
 	uint_size_obj loc = 0;
 	uint_size_obj loc_env = __objctr.obj_loc(tok.value_1);
 	uint_size_obj loc_tmp = __tmpctr.obj_loc(tok.value_1);
-	bool isenv = false;
+	uint_size_obj ienv = 0;
 
 	if (loc_tmp != __tmpctr.obj_len_in_all())
 		loc = loc_tmp;
 	else if (loc_env != __objctr.obj_len_in_all()) {
 		if (__objctr.is_preload(loc_env))
 			twarn(ErrCompile_AsgDefault).warn("tcp::parse_asg", tok.value_1);
-		loc = loc_env;
-		isenv = true;
+		loc = __objctr.obj_slot(tok.value_1, ienv);
+		ienv++;
 	} else
 		twarn(ErrCompile_ObjUnfound).warn("tcp::parse_asg", tok.value_1);
 
 	parse_unit(tok.value_2, tcmds, consts, paths, 0, inblk);
-	tcmds.append(tbycode(OP_POPCOV, loc, isenv));
+	tcmds.append(tbycode(OP_POPCOV, loc, ienv));
 	__regctr.ddt_stk_ctr();
 }
 
@@ -806,15 +891,16 @@ void parse_idxl(const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts,
 	uint_size_obj loc = 0;
 	uint_size_obj loc_tmp = __tmpctr.obj_loc(tok.value_1);
 	uint_size_obj loc_env = __objctr.obj_loc(tok.value_1);
-	bool isenv = false;
+	uint_size_obj ienv = 0;
 
 	if (loc_tmp != __tmpctr.obj_len_in_all())
 		loc = loc_tmp;
 	else if (loc_env != __objctr.obj_len_in_all()) {
 		if (__objctr.is_preload(loc_env))
 			twarn(ErrCompile_AsgDefault).warn("tcp::parse_idxl", tok.value_1);
-		loc = loc_env;
-		isenv = true;
+		loc = __objctr.obj_slot(tok.value_1, ienv);
+		if (++ienv > 15)  // the range of `i` of Lbi bycodes
+			twarn(ErrCompile_OBJOutOfLimit).warn("tcp::parse_idxl", tok.value_1);
 	} else
 		twarn(ErrCompile_ObjUnfound).warn("tcp::parse_idxl", tok.value_1);
 
@@ -823,7 +909,7 @@ void parse_idxl(const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts,
 	// Compile the parameters as indexes
 	uint_size_stk n = parse_params(tok.value_2, tcmds, consts, paths, inblk);
 	// OP_IDXL
-	tcmds.append(tbycode(OP_IDXL, loc, n, isenv));
+	tcmds.append(tbycode(OP_IDXL, loc, n, uint8_t(ienv)));
 	__regctr.ddt_stk_ctr_n(n + 1);
 }
 
@@ -889,12 +975,56 @@ void parse_eval(const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts,
 	__regctr.add_stk_ctr_n(1);      // returned value
 }
 
+/** Get the keys and values of a dictionary of constant keys
+ *  @return whether all `params` are `key : value` of distinct string literals
+ *          as keys
+ */
+bool get_record_params(const std::vector<std::string> & params,
+		std::vector<std::string> & keys, std::vector<std::string> & values)
+{
+	for (auto iter = params.begin(); iter != params.end(); iter++) {
+		std::string unit = *iter;
+		std::vector<ttoken> tokens, keytokens;
+
+		tunit_splitter().preprocessing(unit);
+		get_tokens(unit, tokens);
+		if (tokens.size() != 1 || tokens[0].type != token_pair)
+			return false;
+		get_tokens(tokens[0].value_1, keytokens);
+		if (keytokens.size() != 1 || (keytokens[0].type != token_sstr && keytokens[0].type != token_dstr))
+			return false;
+		for (auto key = keys.begin(); key != keys.end(); key++)
+			if (*key == keytokens[0].value_1)
+				return false;
+		keys.push_back(keytokens[0].value_1);
+		values.push_back(tokens[0].value_2);
+	}
+	return !keys.empty();
+}
+
 /** Parse dictionary
+ *  @details A dictionary of constant keys is compiled into a record: its
+ *  values, then OP_PUSHREC followed by OP_PUSHS of the keys, which are not
+ *  executed but read by OP_PUSHREC.
  */
 void parse_dict(const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts,
 		std::vector<std::string> & paths, bool inblk)
 {
-	uint_size_stk n = parse_params(tok.value_1, tcmds, consts, paths, inblk);
+	std::vector<std::string> params, keys, values;
+	tunit_splitter().split_params_by_comma(tok.value_1, params);
+
+	if (get_record_params(params, keys, values)) {
+		parse_unit_seqs(values, tcmds, consts, paths, 0, inblk);
+		tcmds.append(tbycode(OP_PUSHREC, static_cast<uint32_t>(keys.size())));
+
+		for (auto iter = keys.begin(); iter != keys.end(); iter++)
+			tcmds.append(tbycode(OP_PUSHS, consts.add_str_const(*iter)));
+		__regctr.ddt_stk_ctr_n(static_cast<uint_size_stk>(keys.size()));
+		__regctr.add_stk_ctr();
+		return;
+	}
+	parse_unit_seqs(params, tcmds, consts, paths, 0, inblk);
+	uint_size_stk n = static_cast<uint_size_stk>(params.size());
 	tcmds.append(tbycode(OP_PUSHDICT, n));
 	__regctr.ddt_stk_ctr_n(n);
 	__regctr.add_stk_ctr();
@@ -977,10 +1107,10 @@ void parse_token(const ttoken & tok, tvmcmd_vect & tcmds, tconsts & consts,
 	switch (tok.type) {
 	// statement
 	case token_continue:
-		tcmds.append(tbycode(OP_CONTI));
+		parse_loopjump(OP_CONTI, tcmds, "continue");
 		break;
 	case token_break:
-		tcmds.append(tbycode(OP_BREAK));
+		parse_loopjump(OP_BREAK, tcmds, "break");
 		break;
 	case token_return:
 		parse_return(tok, tcmds, consts, paths, inblk);
@@ -1148,6 +1278,8 @@ tcp(tobj_ctr * father_objctr, bool interactive = true)
 	__objctr = tobj_ctr(father_objctr);
 	__n_default_objs = 0;
 	__interactive = interactive;
+	__superins = true;
+	__optlevel = 2;
 }
 
 /** Constructor of the compiler
@@ -1160,6 +1292,20 @@ tcp(const std::vector<std::string> & default_objs, tobj_ctr * father_objctr, boo
 	__objctr = tobj_ctr(default_objs, father_objctr);
 	__n_default_objs = default_objs.size();
 	__interactive = interactive;
+	__superins = true;
+	__optlevel = 2;
+}
+
+/// Turn on/off the fusion of bycodes into superinstructions
+void set_superins(bool superins)
+{
+	__superins = superins;
+}
+
+/// Set the level of static optimization of bycodes: 0, 1 or 2 (default)
+void set_optlevel(uint8_t optlevel)
+{
+	__optlevel = optlevel;
 }
 
 /// @return Compilation information incluing environmental/temporary objects
@@ -1279,7 +1425,7 @@ twrapper * compile_str(const std::string & str, std::vector<std::string> & paths
 
 	try {
 		tcinfo info = parse_blk(str, tcmds, consts, paths, 1, 0);
-		wrapper = tanalyser().wrap(tcmds, consts, info);
+		wrapper = tanalyser(__superins, __optlevel).wrap(tcmds, consts, info);
 	} catch(...) {
 		tanalyser().clean_wrapper(wrapper);
 		twarn(ErrCompile_Other).warn("tcp::compile_str", str);
@@ -1316,7 +1462,7 @@ twrapper * compile_file_2(const std::string & file, std::vector<std::string> & p
 		tcinfo info = ismd ? \
 				  parse_md_file(f, tcmds, consts, paths)
 				: parse_file(f, tcmds, consts, paths);
-		wrapper = tanalyser().wrap(tcmds, consts, info);
+		wrapper = tanalyser(__superins, __optlevel).wrap(tcmds, consts, info);
 	} catch(...) {
 		fclose(f);
 		tanalyser().clean_wrapper(wrapper);
@@ -34,7 +34,7 @@ enum tcompo_type : uint8_t
 {
 	compo_tpair,      ///< Type **pair**, a shorter list consisting only two elements.
 	compo_tstr,       ///< Type **str**, a wrapper of std::string type.
-	compo_tdict,      ///< Type **dict**, a wrapper of std::unsorted_map type.
+	compo_tdict,      ///< Type **dict**, a flat hash table of strings.
 	compo_tlist,      ///< Type **list**, a wrapper of std::vector type.
 	compo_time,       ///< Type **time**, a wrapper of std::tm
 	compo_titer,      ///< Type **iter**, consisting of four integers marking the indexes.
@@ -45,9 +45,419 @@ enum tcompo_type : uint8_t
 	compo_tdarr,      ///< Type **darr**, a wrapper of Eigen::Matrix of double floats.
 	compo_tbarr,      ///< Type **barr**, a wrapper of Eigen::Matrix of booleans.
 	compo_tlib,       ///< Type **lib**, Tap library, providing a basic runtime environment.
+	compo_trecord,    ///< Type **dict** of constant keys, values by the offsets of a shared shape.
+	compo_user,       ///< First code of user types, see tcompo_register.
 };
 
 
+/** Define `Tap_ATOMIC_REFCTR` to count the references of the values
+ *  atomically, so that values not traced by the cycle collector (strings,
+ *  iterators, ..., see tcompo_v::gc_track) may be shared by sessions run on
+ *  different threads. The slab and the cycle collector current are then per
+ *  thread, and the values are allocated by ::operator new (see tslab).
+ */
+#ifdef Tap_ATOMIC_REFCTR
+#define Tap_SESSION_LOCAL thread_local
+#ifndef Tap_NO_SLAB
+#define Tap_NO_SLAB
+#endif
+#else
+#define Tap_SESSION_LOCAL
+#endif
+
+/// Keep a rare path out of the fast paths inlining it
+#if defined(__GNUC__)
+#define Tap_NOINLINE __attribute__((noinline))
+#else
+#define Tap_NOINLINE
+#endif
+
+/// Types of values accounted by tmem, the user types together
+#define Tap_MEM_NTYPES (compo_user + 1)
+
+/// Statistics of the memory of the values of a session
+struct tmem_stats
+{
+	uint64_t bytes;                   ///< bytes in use
+	uint64_t peak;                    ///< most bytes in use
+	uint64_t limit;                   ///< bytes in use at most, 0 if unlimited
+	uint64_t nvalues[Tap_MEM_NTYPES]; ///< values in use by type
+	uint64_t nbytes[Tap_MEM_NTYPES];  ///< bytes in use by type
+};
+
+/// Counter of tmem, freed values being discharged by any thread if
+/// `Tap_ATOMIC_REFCTR` is defined
+#ifdef Tap_ATOMIC_REFCTR
+typedef std::atomic<uint64_t> tmem_ctr;
+#else
+typedef uint64_t tmem_ctr;
+#endif
+
+/** Memory accounting of composite values (see tcompo_v::alloc)
+ *  @details The values are accounted by their type as allocated and freed,
+ *  with the storage they own: the buffers of the Eigen arrays (as type
+ *  **arr**), the tables of dicts, the elements of lists and the characters
+ *  of strings, charged as they grow and discharged as freed. Each slab has its own
+ *  accounting, the one of the values it allocates, which are discharged
+ *  from it whichever slab is current when they are freed. A value records
+ *  the accounting it is charged to (see tslab), and so does a value charging
+ *  the storage it owns. Allocating beyond the limit is a runtime error.
+ *  The accounting is released once its slab and the values allocated out of
+ *  the chunks of its slab are.
+ */
+class tmem
+{
+private:
+	tmem_ctr __nrefs;   /// the slab and the values allocated out of its chunks
+	tmem_ctr __mark;    /// bytes in use beyond which to check the limit or the peak
+	tmem_ctr __bytes;
+	tmem_ctr __peak;
+	tmem_ctr __limit;
+	tmem_ctr __nvalues[Tap_MEM_NTYPES];
+	tmem_ctr __nbytes[Tap_MEM_NTYPES];
+
+/// Check `bytes` in use, `nbytes` more, against the limit, then take them as
+/// the peak
+Tap_NOINLINE void grow(uint64_t bytes, std::size_t nbytes)
+{
+	uint64_t limit = __limit;
+
+	if (limit != 0 && bytes > limit) {
+		__bytes -= nbytes;
+		twarn(ErrRuntime_MemLimit).warn("tmem::charge", std::to_string(limit) + " bytes at most");
+	}
+	uint64_t peak = __peak;
+
+	if (bytes > peak)
+		__peak = peak = bytes;
+	__mark = limit != 0 && limit < peak ? limit : peak;
+}
+
+~tmem() {}
+
+public:
+tmem()
+{
+	__nrefs = 1;
+	__mark = __bytes = __peak = __limit = 0;
+	for (uint8_t i = 0; i < Tap_MEM_NTYPES; i++)
+		__nvalues[i] = __nbytes[i] = 0;
+}
+
+/// Hold `this` for a value referring to it
+void hold()
+{
+	__nrefs++;
+}
+
+/// Release `this` if not held any more (see hold)
+void release()
+{
+	if (--__nrefs == 0)
+		delete this;
+}
+
+/// Account `nbytes` more of `type`, by a new value if `nvalues` is 1
+void charge(tcompo_type type, std::size_t nbytes, uint8_t nvalues)
+{
+	uint8_t i = type < compo_user ? type : compo_user;
+	uint64_t bytes = (__bytes += nbytes);
+
+	if (bytes > __mark)
+		grow(bytes, nbytes);
+	__nbytes[i] += nbytes;
+	__nvalues[i] += nvalues;
+}
+
+/// Account `nbytes` less of `type`, by a value freed if `nvalues` is 1
+void discharge(tcompo_type type, std::size_t nbytes, uint8_t nvalues)
+{
+	uint8_t i = type < compo_user ? type : compo_user;
+
+	__bytes -= nbytes;
+	__nbytes[i] -= nbytes;
+	__nvalues[i] -= nvalues;
+}
+
+/// Set the bytes in use at most, 0 if unlimited
+void set_limit(uint64_t limit)
+{
+	uint64_t peak = __peak;
+
+	__limit = limit;
+	__mark = limit != 0 && limit < peak ? limit : peak;
+}
+
+/// @return the statistics of this accounting
+tmem_stats get_stats() const
+{
+	tmem_stats stats;
+
+	stats.bytes = __bytes;
+	stats.peak = __peak;
+	stats.limit = __limit;
+	for (uint8_t i = 0; i < Tap_MEM_NTYPES; i++) {
+		stats.nvalues[i] = __nvalues[i];
+		stats.nbytes[i] = __nbytes[i];
+	}
+	return stats;
+}
+
+/// @return the name of the type of values `i` (< Tap_MEM_NTYPES)
+static const char * type_name(uint8_t i)
+{
+	static const char * names[Tap_MEM_NTYPES] = {
+		"pair", "str", "dict", "list", "time", "iter", "func", "cppfunc",
+		"sessfunc", "arr", "darr", "barr", "lib", "record", "user"
+	};
+	return names[i];
+}
+
+};
+
+
+/// Size classes of the slab allocator, by 16 bytes up to 256 bytes
+#define Tap_SLAB_GRAIN    16
+#define Tap_SLAB_NCLASSES 16
+/// Chunks of the slab allocator, aligned to their size
+#define Tap_SLAB_CHUNK    (64 * 1024)
+
+/// Statistics of a slab allocator
+struct tslab_stats
+{
+	uint64_t nallocs;                 ///< blocks allocated
+	uint64_t nreuses;                 ///< blocks allocated from the free lists
+	uint64_t nfrees;                  ///< blocks freed
+	uint64_t nlarge;                  ///< values too large for the size classes
+	uint64_t nchunks;                 ///< chunks held
+	uint64_t live[Tap_SLAB_NCLASSES]; ///< blocks in use by size class
+};
+
+/** Slab allocator of composite values (see tcompo_v::operator new)
+ *  @details Values of up to 256 bytes are carved from chunks of 64 KiB by
+ *  size classes of 16 bytes, and freed to a list by class. A chunk starts
+ *  with the slab owning it, so that a block is freed to its slab whichever
+ *  slab is current. A session makes its own slab current while it runs
+ *  (see tsession::tscope), and releases all its chunks at once when it is
+ *  destroyed.
+ *  Larger values are allocated by ::operator new, after 16 bytes recording
+ *  the accounting of the slab (see tmem). Define `Tap_NO_SLAB` to allocate
+ *  all the values so (e.g. for memory checkers).
+ */
+class tslab
+{
+private:
+	struct tchunk
+	{
+		tslab  * slab;  ///< owner
+		void   * mem;   ///< allocated memory, aligned to the chunk
+		tchunk * next;
+	};
+
+	void      * __free[Tap_SLAB_NCLASSES]; /// free lists by size class
+	char      * __cur;                     /// next block of the current chunk
+	char      * __end;                     /// end of the current chunk
+	tchunk    * __chunks;                  /// chunks held
+	tmem      * __mem;                     /// accounting of the values
+	tslab_stats __stats;
+
+/// @return the slab current (nullptr before the first allocation)
+static tslab *& current()
+{
+	static Tap_SESSION_LOCAL tslab * slab = nullptr;
+	return slab;
+}
+
+/// Get a new chunk as the current one
+void new_chunk()
+{
+	char * mem = static_cast<char *>(::operator new(2 * Tap_SLAB_CHUNK));
+	uintptr_t aligned = (reinterpret_cast<uintptr_t>(mem) + Tap_SLAB_CHUNK - 1) & ~uintptr_t(Tap_SLAB_CHUNK - 1);
+	tchunk * chunk = reinterpret_cast<tchunk *>(aligned);
+
+	chunk->slab = this;
+	chunk->mem = mem;
+	chunk->next = __chunks;
+	__chunks = chunk;
+	__cur = reinterpret_cast<char *>(chunk) + ((sizeof(tchunk) + Tap_SLAB_GRAIN - 1) / Tap_SLAB_GRAIN) * Tap_SLAB_GRAIN;
+	__end = reinterpret_cast<char *>(chunk) + Tap_SLAB_CHUNK;
+	__stats.nchunks++;
+}
+
+/// @return a block of `size` bytes by ::operator new, after the accounting
+/// of this slab, held by the block
+void * alloc_large(std::size_t size)
+{
+	char * mem = static_cast<char *>(::operator new(Tap_SLAB_GRAIN + size));
+
+	*reinterpret_cast<tmem **>(mem) = __mem;
+	__mem->hold();
+	__stats.nlarge++;
+	return mem + Tap_SLAB_GRAIN;
+}
+
+/// Free `block` of `size` bytes (see alloc_large), of `type` (see alloc)
+static void free_large(void * block, std::size_t size, tcompo_type type, uint8_t nvalues)
+{
+	char * mem = static_cast<char *>(block) - Tap_SLAB_GRAIN;
+	tmem * owner = *reinterpret_cast<tmem **>(mem);
+
+	owner->discharge(type, size, nvalues);
+	owner->release();
+	::operator delete(mem);
+}
+
+public:
+tslab()
+{
+	for (uint8_t i = 0; i < Tap_SLAB_NCLASSES; i++)
+		__free[i] = nullptr;
+	__cur = __end = nullptr;
+	__chunks = nullptr;
+	__mem = new tmem();
+	__stats = tslab_stats();
+}
+
+/// Release all the chunks, whether their values are freed or not
+~tslab()
+{
+	if (current() == this)
+		current() = nullptr;
+	while (__chunks != nullptr) {
+		tchunk * next = __chunks->next;
+		::operator delete(__chunks->mem);
+		__chunks = next;
+	}
+	__mem->release();
+}
+
+/// Allocate the values from this slab until `leave`
+/// @return the slab current before
+tslab * enter()
+{
+	tslab * prev = current();
+
+	current() = this;
+	return prev;
+}
+
+/// Make `prev`, returned by `enter`, current again
+static void leave(tslab * prev)
+{
+	current() = prev;
+}
+
+/// @return the slab of new values, a default one (never released) if none
+static tslab * get_current()
+{
+	tslab *& slab = current();
+
+	if (slab == nullptr) {
+		static Tap_SESSION_LOCAL tslab * fallback = nullptr;
+
+		if (fallback == nullptr)
+			fallback = new tslab();
+		slab = fallback;
+	}
+	return slab;
+}
+
+/// @return the accounting of the values of this slab
+tmem * get_mem() const
+{
+	return __mem;
+}
+
+/// @return a block of `size` bytes for a value of `type`, accounted (as
+/// storage of values of `type` if `nvalues` is 0)
+void * alloc(std::size_t size, tcompo_type type, uint8_t nvalues = 1)
+{
+	__mem->charge(type, size, nvalues);
+#ifdef Tap_NO_SLAB
+	return alloc_large(size);
+#else
+	if (size > Tap_SLAB_GRAIN * Tap_SLAB_NCLASSES)
+		return alloc_large(size);
+	uint8_t cls = static_cast<uint8_t>((size - 1) / Tap_SLAB_GRAIN);
+	void * block = __free[cls];
+
+	__stats.nallocs++;
+	__stats.live[cls]++;
+	if (block != nullptr) {
+		__free[cls] = *static_cast<void **>(block);
+		__stats.nreuses++;
+		return block;
+	}
+	std::size_t bytes = (cls + 1) * Tap_SLAB_GRAIN;
+
+	if (__cur + bytes > __end)
+		new_chunk();
+	block = __cur;
+	__cur += bytes;
+	return block;
+#endif
+}
+
+/// Free `block` of `size` bytes, of `type` (see alloc), to the slab owning it
+static void free(void * block, std::size_t size, tcompo_type type, uint8_t nvalues = 1)
+{
+#ifdef Tap_NO_SLAB
+	free_large(block, size, type, nvalues);
+#else
+	if (size > Tap_SLAB_GRAIN * Tap_SLAB_NCLASSES) {
+		free_large(block, size, type, nvalues);
+		return;
+	}
+	uint8_t cls = static_cast<uint8_t>((size - 1) / Tap_SLAB_GRAIN);
+	uintptr_t chunk = reinterpret_cast<uintptr_t>(block) & ~uintptr_t(Tap_SLAB_CHUNK - 1);
+	tslab * slab = reinterpret_cast<tchunk *>(chunk)->slab;
+
+	slab->__mem->discharge(type, size, nvalues);
+	*static_cast<void **>(block) = slab->__free[cls];
+	slab->__free[cls] = block;
+	slab->__stats.nfrees++;
+	slab->__stats.live[cls]--;
+#endif
+}
+
+/// @return the statistics of this slab
+const tslab_stats & get_stats() const
+{
+	return __stats;
+}
+
+};
+
+
+class tcompo_v;
+
+/// Visitor of the composite values referred by a value (see tgc)
+typedef void (* tgc_visitf)(tcompo_v *, void *);
+
+/// Flags of the values for the cycle collector (see tgc)
+#define Tap_GC_TRACED   0x01  ///< the value may refer to others
+#define Tap_GC_BUFFERED 0x02  ///< the value is among the possible roots
+#define Tap_GC_COLOR    0x0C  ///< color of the value (below)
+#define Tap_GC_BLACK    0x00  ///< in use
+#define Tap_GC_GRAY     0x04  ///< possible member of a cycle
+#define Tap_GC_WHITE    0x08  ///< member of a garbage cycle
+#define Tap_GC_PURPLE   0x0C  ///< possible root of a cycle
+#define Tap_GC_HELD     0x10  ///< the value may be held by temporary objects of tvm
+#define Tap_GC_DEFERRED 0x20  ///< the value is among the values to be released
+#define Tap_GC_FLAGS    0xFF  ///< the flags above
+#define Tap_GC_MAXROOTS (uint32_t(1) << 24) ///< possible roots buffered at most
+
+/// Allocation functions of the values of a type `code` (see tcompo_v::alloc)
+#define Tap_COMPO_ALLOC(code) \
+static void * operator new(std::size_t size) { return tcompo_v::alloc(size, code); } \
+static void operator delete(void * p, std::size_t size) { tcompo_v::dealloc(p, size, code); }
+
+/// Allocation functions of the storage shared by values of a type `code`,
+/// accounted as theirs but not as values (see tlist::copy)
+#define Tap_STORAGE_ALLOC(code) \
+static void * operator new(std::size_t size) { return tcompo_v::alloc(size, code, 0); } \
+static void operator delete(void * p, std::size_t size) { tcompo_v::dealloc(p, size, code, 0); }
+
 /** Composite data in Tap
  *  @details A reference counter is maintained in tcompo_v. General methods of
  *    reference types including `tostring`, `get_type`, `copy`,
@@ -56,17 +466,66 @@ enum tcompo_type : uint8_t
 class tcompo_v
 {
 private:
-	uint16_t __refctr;
+#ifdef Tap_ATOMIC_REFCTR
+	std::atomic<uint32_t> __refctr;
+#else
+	uint32_t __refctr;
+#endif
+	uint32_t __gcinfo;  ///< flags of tgc (bits 0 - 7), location among its possible roots (or deferred values)
+
+	friend class tgc;
+
+/// Buffer `this` as a possible root of a cycle (see tgc)
+void gc_possible_root();
+
+/// Remove `this` from the possible roots, or the deferred values (see tgc)
+void gc_unbuffer();
+
+/// Release `this` at the next safe point (see tgc::defer)
+void gc_defer();
 
 public:
 /// Contructor: reference counter = 0, expression type = constant
 tcompo_v()
 {
 	__refctr = 0;
+	__gcinfo = 0;
 }
 
+/// Copy contructor: a new value, not referred yet
+tcompo_v(const tcompo_v &) : tcompo_v() {}
+
 /// Deconstructor (virtual)
-virtual ~tcompo_v() {};
+virtual ~tcompo_v()
+{
+	if (__gcinfo & (Tap_GC_BUFFERED | Tap_GC_DEFERRED))
+		gc_unbuffer();
+}
+
+/// Allocate a value of `type` from the current slab, or the storage of
+/// values of `type` if `nvalues` is 0 (see tslab, tmem)
+static void * alloc(std::size_t size, tcompo_type type, uint8_t nvalues = 1)
+{
+	return tslab::get_current()->alloc(size, type, nvalues);
+}
+
+/// Free a value of `type` to its slab, `size` being of the dynamic type
+static void dealloc(void * p, std::size_t size, tcompo_type type, uint8_t nvalues = 1)
+{
+	tslab::free(p, size, type, nvalues);
+}
+
+/// Allocate a value of user types (see Tap_COMPO_ALLOC)
+static void * operator new(std::size_t size)
+{
+	return alloc(size, compo_user);
+}
+
+/// Free a value of user types
+static void operator delete(void * p, std::size_t size)
+{
+	dealloc(p, size, compo_user);
+}
 
 /// Reference counter add by one
 inline void add_refctr()
@@ -74,14 +533,84 @@ inline void add_refctr()
 	__refctr++;
 }
 
-/// Reference counter deducted by one
-inline void ddc_refctr()
+/** Reference counter deducted by one. A value of containers still referred
+ *  may be in a cycle (see tgc)
+ *  @return the reference counter deducted, i.e. 0 if the value is no longer
+ *  referred (even if the counter is atomic)
+ */
+inline uint32_t ddc_refctr()
 {
+#ifdef Tap_ATOMIC_REFCTR
+	uint32_t refctr = --__refctr;
+
+	if (refctr != 0 && (__gcinfo & Tap_GC_TRACED))
+		gc_possible_root();
+	return refctr;
+#else
 	__refctr--;
+	if (__refctr != 0 && (__gcinfo & Tap_GC_TRACED))
+		gc_possible_root();
+	return __refctr;
+#endif
+}
+
+/** Mark `this` as held by a temporary object of tvm, whose references are
+ *  not counted (see release). If `Tap_ATOMIC_REFCTR` is defined, a value not
+ *  traced may be shared by threads, and freed by one while a temporary
+ *  object of another holds it: its reference by the temporary object is
+ *  counted instead (see drop_held)
+ */
+inline void gc_hold()
+{
+#ifdef Tap_ATOMIC_REFCTR
+	if (!(__gcinfo & Tap_GC_TRACED)) { // its flags are not changed by tgc
+		__refctr++;
+		return;
+	}
+#endif
+	__gcinfo |= Tap_GC_HELD;
 }
 
+/// Free `this`, no longer referred. A value that may be held by temporary
+/// objects is released at the next safe point instead (see tgc::defer)
+inline void release()
+{
+	if (__gcinfo & Tap_GC_HELD)
+		gc_defer();
+	else
+		delete this;
+}
+
+/// Drop a reference not counted, e.g. of a temporary object of tvm: `this`
+/// is released if not referred, otherwise it may be in a cycle (see tgc)
+inline void drop_held()
+{
+#ifdef Tap_ATOMIC_REFCTR
+	if (!(__gcinfo & Tap_GC_TRACED)) { // counted (see gc_hold)
+		if (--__refctr == 0)
+			delete this;
+		return;
+	}
+#endif
+	if (__refctr == 0)
+		release();
+	else if (__gcinfo & Tap_GC_TRACED)
+		gc_possible_root();
+}
+
+/// Trace `this` by the cycle collector, by the constructors of the values
+/// that may refer to others (see gc_traverse)
+void gc_track();
+
+/// Visit the composite values referred by `this` (none by default)
+virtual void gc_traverse(tgc_visitf, void *) {}
+
+/// Drop the references to the values referred by `this`, whose cycle is
+/// freed by the cycle collector (see gc_traverse)
+virtual void gc_clear() {}
+
 /// Get reference counter
-inline uint16_t get_refctr() const
+inline uint32_t get_refctr() const
 {
 	return __refctr;
 }
@@ -125,6 +654,8 @@ virtual bool identical(tcompo_v * v) const = 0;
 
 };
 
+static_assert(sizeof(void *) != 8 || sizeof(tcompo_v) == 16, "the header of values is 16 bytes on 64-bit platforms");
+
 
 /// Data of objects in Tap.
 union tdata
@@ -134,15 +665,34 @@ union tdata
 	tcompo_v * compo;  ///< Storage for compo values
 };
 
-
-/// Objects in Tap where `data` and `type` are maintained
+#ifdef Tap_NAN_BOXING
+/** 8-byte objects (NaN-boxing)
+ *  @details A double float is stored as it is, NaNs being made positive. The
+ *  other values are negative quiet NaNs: the type is at bits 48 - 50 and the
+ *  value (the pointer of compo, or the integer) at bits 0 - 47. Integers are
+ *  thus 48-bit (an error out of the range, not wrapped), and pointers are
+ *  required to be 48-bit as well (x86-64 and AArch64 user space).
+ */
+#define Tap_BOX_TAG(type)  ((uint64_t(0x1FFF) << 51) | (uint64_t(type) << 48))
+#define Tap_BOX_PAYLOAD    ((uint64_t(1) << 48) - 1)
+#define Tap_BOX_INT_BIAS   (uint64_t(1) << 47)
+#define Tap_BOX_NAN        (uint64_t(0x7FF8) << 48)
+#endif
+
+/** Objects in Tap where `data` and `type` are maintained
+ *  @details An object is 16 bytes, or 8 bytes if `Tap_NAN_BOXING` is defined.
+ *  The names of environmental objects are kept by their environment, see
+ *  tobj_array.
+ */
 class tobj
 {
 private:
+#ifdef Tap_NAN_BOXING
+	uint64_t  __bits;
+#else
 	ttypes    __type;
-	uint_size_obj __env_loc;
-	uint_size_obj __name_loc;
 	tdata     __data;
+#endif
 
 /// @return a string of this is a value type object
 std::string tostring_values() const
@@ -154,14 +704,14 @@ std::string tostring_values() const
 		out += "nil";
 		break;
 	case tbool:
-		if (__data.i) out += "true";
-		else         out += "false";
+		if (get_v_tbool()) out += "true";
+		else               out += "false";
 		break;
 	case tint:
-		out += std::to_string(__data.i);
+		out += std::to_string(get_v_tint());
 		break;
 	case tdouble:
-		out += std::to_string(__data.d);
+		out += std::to_string(get_v_tdouble());
 		break;
 	case tcompo:
 		break;
@@ -169,85 +719,35 @@ std::string tostring_values() const
 	return out;
 }
 
-/// Fill in __data
-void set_data(tdata data)
-{
-	__data = data;
-}
-
-/// Set type `type`
-void set_type(ttypes type)
-{
-	__type = type;
-}
-
-/// Set __data.i to be a boolean value `vbool`
-void set_v_tbool(long vbool)
-{
-	__data.i = vbool;
-}
-
-/// Set __data.i to be an integer value `i`
-void set_v_tint(long i)
-{
-	__data.i = i;
-}
-
-/// Set __data.d to be a double float value `d`
-void set_v_tdouble(double d)
-{
-	__data.d = d;
-}
-
-/// Set __data.compo to be a composite value `v`
-void set_v_tcompo(tcompo_v * v)
-{
-	__data.compo = v;
-}
-
 public:
 /// Constructor: a nil type object in default
-tobj(uint_size_obj obj_loc = UNDEF_ENVLOC, uint_size_cst name_loc = UNDEF_NAMELOC)
+tobj()
 {
 	set_nil();
-	__env_loc = obj_loc;
-	__name_loc = name_loc;
 }
 
 /// Constructor: a boolean object in default
-tobj(bool bv, uint_size_obj obj_loc = UNDEF_ENVLOC, uint_size_cst name_loc = UNDEF_NAMELOC)
+tobj(bool bv)
 {
-	set_type(tbool);
-	set_v_tbool(bv);
-	__env_loc = obj_loc;
-	__name_loc = name_loc;
+	set_v(bv);
 }
 
 /// Constructor: an integer object in default
-tobj(long iv, uint_size_obj obj_loc = UNDEF_ENVLOC, uint_size_cst name_loc = UNDEF_NAMELOC)
+tobj(long iv)
 {
-	set_type(tint);
-	set_v_tint(iv);
-	__env_loc = obj_loc;
-	__name_loc = name_loc;
+	set_v(iv);
 }
 
 /// Constructor: a double float object in default
-tobj(double dv, uint_size_obj obj_loc = UNDEF_ENVLOC, uint_size_cst name_loc = UNDEF_NAMELOC)
+tobj(double dv)
 {
-	set_type(tdouble);
-	set_v_tdouble(dv);
-	__env_loc = obj_loc;
-	__name_loc = name_loc;
+	set_v(dv);
 }
 
 /// Constructor: a composite object in default
-tobj(tcompo_v * cv, uint_size_obj obj_loc = UNDEF_ENVLOC, uint_size_cst name_loc = UNDEF_NAMELOC)
+tobj(tcompo_v * cv)
 {
-	set_type(tcompo);
-	set_v_tcompo(cv);
-	__env_loc = obj_loc;
-	__name_loc = name_loc;
+	set_v(cv);
 }
 
 /// Deconstructor
@@ -258,10 +758,10 @@ tobj(tcompo_v * cv, uint_size_obj obj_loc = UNDEF_ENVLOC, uint_size_cst name_loc
 void try_clear(bool ddt_refctr = false)
 {
 	if (get_type() == tcompo) {
-		if (ddt_refctr)
-			__data.compo->ddc_refctr();
-		if (__data.compo->get_refctr() == 0)
-			delete __data.compo;
+		tcompo_v * compo = get_v_tcompo();
+
+		if ((ddt_refctr ? compo->ddc_refctr() : compo->get_refctr()) == 0)
+			compo->release();
 	}
 	set_nil();
 }
@@ -279,70 +779,129 @@ bool is_compo() const
 	return get_type() == tcompo;
 }
 
-/// Set the location of name in Constant list of string.
-void set_name_loc(uint_size_cst loc)
+#ifdef Tap_NAN_BOXING
+/// Set the type to be `tnil`
+void set_nil()
+{
+	__bits = Tap_BOX_TAG(tnil);
+}
+
+/// Set the type and data of this object that type and data of `v`
+void set_v(const tobj & v)
+{
+	__bits = v.__bits;
+}
+
+/// Set type to be tcompo and data to be `comp`
+void set_v(tcompo_v * comp)
+{
+	__bits = Tap_BOX_TAG(tcompo) | reinterpret_cast<uintptr_t>(comp);
+}
+
+/// Set type to be tbool and data to be `b`
+void set_v(bool b)
+{
+	__bits = Tap_BOX_TAG(tbool) | uint64_t(b);
+}
+
+/// Set type to be tint and data to be `i`, an error out of 48 bits (see
+/// int_out_of_range)
+void set_v(long i)
 {
-	__name_loc = loc;
+	if (static_cast<uint64_t>(i) + Tap_BOX_INT_BIAS > Tap_BOX_PAYLOAD)
+		int_out_of_range(i);
+	__bits = Tap_BOX_TAG(tint) | (static_cast<uint64_t>(i) & Tap_BOX_PAYLOAD);
 }
 
-/// Set the location of object in list of environmental objects.
-void set_env_loc(uint_size_obj loc)
+/// Raise an error for the integer `i`, out of the 48 bits of a boxed one
+static Tap_NOINLINE void int_out_of_range(long i)
 {
-	__env_loc = loc;
+	twarn(ErrRuntime_IntOutOfRange).warn("tobj::set_v", std::to_string(i) + " out of 48 bits");
 }
 
+/// Set type to be tdouble and data to be `d`
+void set_v(double d)
+{
+	if (d != d)
+		__bits = Tap_BOX_NAN;
+	else
+		std::memcpy(&__bits, &d, sizeof(double));
+}
+
+/// Get type
+ttypes get_type() const
+{
+	if ((__bits >> 51) != 0x1FFF)
+		return tdouble;
+	return ttypes((__bits >> 48) & 7);
+}
+
+/// Get the boolean value
+long get_v_tbool() const
+{
+	return static_cast<long>(__bits & Tap_BOX_PAYLOAD);
+}
+
+/// Get the integer value
+long get_v_tint() const
+{
+	return static_cast<long>(__bits << 16) >> 16;
+}
+
+/// Get the double float value
+double get_v_tdouble() const
+{
+	double d;
+	std::memcpy(&d, &__bits, sizeof(double));
+	return d;
+}
+
+/// Get the composite value
+tcompo_v * get_v_tcompo() const
+{
+	return reinterpret_cast<tcompo_v *>(static_cast<uintptr_t>(__bits & Tap_BOX_PAYLOAD));
+}
+#else
 /// Set the type to be `tnil` and the data to be 0
 void set_nil()
 {
-	set_type(tnil);
-	set_v_tint(0);
+	__type = tnil;
+	__data.i = 0;
 }
 
 /// Set the type and data of this object that type and data of `v`
 void set_v(const tobj & v)
 {
-	set_type(v.get_type());
-	set_data(v.__data);
+	__type = v.__type;
+	__data = v.__data;
 }
 
 /// Set type to be tcompo and data to be `comp`
 void set_v(tcompo_v * comp)
 {
-	set_type(tcompo);
-	set_v_tcompo(comp);
+	__type = tcompo;
+	__data.compo = comp;
 }
 
 /// Set type to be tbool and data to be `b`
 void set_v(bool b)
 {
-	set_type(tbool);
-	set_v_tbool(b);
+	__type = tbool;
+	__data.i = b;
 }
 
 /// Set type to be tint and data to be `i`
 void set_v(long i)
 {
-	set_type(tint);
-	set_v_tint(i);
+	__type = tint;
+	__data.i = i;
 }
 
 /// Set type to be tdouble and data to be `d`
 void set_v(double d)
 {
-	set_type(tdouble);
-	set_v_tdouble(d);
-}
-
-/// Get the location of object in environmental object list
-uint_size_obj get_obj_loc() const
-{
-	return __env_loc;
-}
-
-/// Get the location of name in constant list of strings
-uint_size_cst get_name_loc() const
-{
-	return __name_loc;
+	__type = tdouble;
+	__data.d = d;
 }
 
 /// Get type
@@ -374,6 +933,7 @@ tcompo_v * get_v_tcompo() const
 {
 	return __data.compo;
 }
+#endif
 
 /// @return a detailed string of this object
 std::string tostring_full() const
@@ -396,7 +956,7 @@ tobj copy()
 /// @return a boolean of Is this object identical to `v`
 bool identical(const tobj & v) const
 {
-	switch (__type) {
+	switch (get_type()) {
 	case tnil:
 		return false;
 	case tbool:
@@ -461,6 +1021,519 @@ bool identical(const tobj & v) const
 
 };
 
+#ifdef Tap_NAN_BOXING
+static_assert(sizeof(void *) == 8 && sizeof(tobj) == 8, "tobj is boxed into 8 bytes on 64-bit platforms");
+#endif
+
+
+/// Traced values allocated between collections of cycles, in default
+#ifndef Tap_GC_THRESHOLD
+#define Tap_GC_THRESHOLD 10000
+#endif
+
+/// Values deferred to be released before they are released at a safe point,
+/// at least (or as many as the values held, see tgc::defer)
+#ifndef Tap_GC_DEFERRED_MAX
+#define Tap_GC_DEFERRED_MAX 64
+#endif
+
+/// Statistics of a cycle collector
+struct tgc_stats
+{
+	uint64_t ntraced;   ///< traced values allocated
+	uint64_t nbuffered; ///< values buffered as possible roots
+	uint64_t ncollects; ///< collections run
+	uint64_t nscanned;  ///< values scanned by the collections
+	uint64_t nfreed;    ///< values freed by the collections
+	uint64_t ndeferred; ///< values whose release was deferred
+};
+
+/// Holder of values without counting their references, e.g. the vmstack
+/// and the temporary objects of tvm, whose values are kept by a collection
+/// (see tgc)
+class tgc_holder
+{
+public:
+virtual ~tgc_holder() {}
+
+/// Visit the values held
+virtual void gc_held(tgc_visitf f, void * arg) = 0;
+};
+
+/** Cycle collector of composite values (Bacon & Rajan, trial deletion)
+ *  @details Reference counting frees a value once it is not referred, but
+ *  not the values referring to each other in a cycle. A traced value (see
+ *  tcompo_v::gc_track) whose counter is deducted without reaching 0 is
+ *  buffered as a possible root of a garbage cycle. A collection deducts the
+ *  references inside the subgraphs of the possible roots: the values still
+ *  referred from outside, and the ones they refer, are kept; the others
+ *  are only referred by each other, and are freed. The values held by the
+ *  holders (see tgc_holder), whose references are not counted, are counted
+ *  while collecting. Only the subgraphs of the values buffered since the
+ *  last collection are scanned.
+ *  A collection is due once `threshold` traced values are allocated, or
+ *  buffered, since the last one, and is run by tvm between bycodes (at the
+ *  backward jumps and the calls of functions), or at once by `sys::__gc__()`. A session makes
+ *  its own collector current while it runs (see tsession::tscope).
+ *  The references by the temporary objects of tvm are not counted either
+ *  (deferred reference counting): a value held by them (see
+ *  tcompo_v::gc_hold) whose counter reaches 0 is deferred, and released at
+ *  the next safe point if none of the holders holds it. The values not traced
+ *  are counted by them if `Tap_ATOMIC_REFCTR` is defined.
+ */
+class tgc
+{
+private:
+	std::vector<tcompo_v *>   __roots;     /// possible roots (nullptr if freed)
+	std::vector<tcompo_v *>   __deferred;  /// values to be released (nullptr if freed)
+	std::vector<tcompo_v *>   __releasing; /// values being released
+	std::vector<tgc_holder *> __holders;   /// holders of values not counted
+	std::vector<tcompo_v *>   __work;      /// values to be visited
+	std::vector<tcompo_v *>   __blacks;    /// values to be visited, being kept
+	uint64_t                  __threshold; /// 0: collect only on demand
+	uint64_t                  __ntraced;   /// traced values since the last collection
+	size_t                    __nheld;     /// values held, at the last collection
+	size_t                    __ndeferred; /// values deferred before a release is due
+	bool                      __due;       /// a collection of cycles, or a release, is due
+	bool                      __cycles;    /// a collection of cycles is due
+	tgc_stats                 __stats;
+
+/// @return the collector current (nullptr before the first use)
+static tgc *& current()
+{
+	static Tap_SESSION_LOCAL tgc * gc = nullptr;
+	return gc;
+}
+
+static uint8_t color(const tcompo_v * v)
+{
+	return v->__gcinfo & Tap_GC_COLOR;
+}
+
+static void set_color(tcompo_v * v, uint8_t color)
+{
+	v->__gcinfo = (v->__gcinfo & ~uint32_t(Tap_GC_COLOR)) | color;
+}
+
+/// Count the reference to `v` held by a holder
+static void pin(tcompo_v * v, void * gc)
+{
+	v->__refctr++;
+	static_cast<tgc *>(gc)->__nheld++;
+}
+
+/// Uncount the reference to `v` held by a holder, `v` being kept by it
+static void unpin(tcompo_v * v, void *)
+{
+	v->__refctr--;
+}
+
+/// Deduct the reference to `v` from inside, and visit `v` if not yet
+static void mark_gray(tcompo_v * v, void * gc)
+{
+	if (!(v->__gcinfo & Tap_GC_TRACED))
+		return;
+	v->__refctr--;
+	if (color(v) != Tap_GC_GRAY) {
+		set_color(v, Tap_GC_GRAY);
+		static_cast<tgc *>(gc)->__work.push_back(v);
+	}
+}
+
+/// Restore the reference to `v` from a value kept, and keep `v` as well
+static void mark_black(tcompo_v * v, void * gc)
+{
+	if (!(v->__gcinfo & Tap_GC_TRACED))
+		return;
+	v->__refctr++;
+	if (color(v) != Tap_GC_BLACK) {
+		set_color(v, Tap_GC_BLACK);
+		static_cast<tgc *>(gc)->__blacks.push_back(v);
+	}
+}
+
+/// Visit `v` if traced
+static void push(tcompo_v * v, void * gc)
+{
+	if (v->__gcinfo & Tap_GC_TRACED)
+		static_cast<tgc *>(gc)->__work.push_back(v);
+}
+
+/// Restore the reference to `v` from a value to be freed
+static void restore(tcompo_v * v, void *)
+{
+	if (v->__gcinfo & Tap_GC_TRACED)
+		v->__refctr++;
+}
+
+/// Deduct the references inside the subgraph of `root`
+void mark_gray_from(tcompo_v * root)
+{
+	set_color(root, Tap_GC_GRAY);
+	__work.push_back(root);
+	while (!__work.empty()) {
+		tcompo_v * v = __work.back();
+		__work.pop_back();
+		__stats.nscanned++;
+		v->gc_traverse(mark_gray, this);
+	}
+}
+
+/// Keep `v` and the values it refers, restoring their references
+void scan_black(tcompo_v * v)
+{
+	set_color(v, Tap_GC_BLACK);
+	__blacks.push_back(v);
+	while (!__blacks.empty()) {
+		tcompo_v * u = __blacks.back();
+		__blacks.pop_back();
+		u->gc_traverse(mark_black, this);
+	}
+}
+
+/// Keep the values of the subgraph of `root` referred from outside, and
+/// whiten the others
+void scan_from(tcompo_v * root)
+{
+	__work.push_back(root);
+	while (!__work.empty()) {
+		tcompo_v * v = __work.back();
+		__work.pop_back();
+
+		if (color(v) != Tap_GC_GRAY)
+			continue;
+		if (v->__refctr > 0)
+			scan_black(v);
+		else {
+			set_color(v, Tap_GC_WHITE);
+			v->gc_traverse(push, this);
+		}
+	}
+}
+
+/// Gather the white values of the subgraph of `root` into `whites`
+void collect_white_from(tcompo_v * root, std::vector<tcompo_v *> & whites)
+{
+	__work.push_back(root);
+	while (!__work.empty()) {
+		tcompo_v * v = __work.back();
+		__work.pop_back();
+
+		if (color(v) != Tap_GC_WHITE)
+			continue;
+		set_color(v, Tap_GC_BLACK);
+		whites.push_back(v);
+		v->gc_traverse(push, this);
+	}
+}
+
+/// Free the values of garbage cycles `whites`: their references are dropped
+/// first, so that each one is freed once not referred
+void free_whites(std::vector<tcompo_v *> & whites)
+{
+	for (auto iter = whites.begin(); iter != whites.end(); iter++) {
+		(*iter)->gc_traverse(restore, this);
+		(*iter)->__refctr++;
+	}
+	for (auto iter = whites.begin(); iter != whites.end(); iter++)
+		(*iter)->gc_clear();
+	for (auto iter = whites.begin(); iter != whites.end(); iter++) {
+		(*iter)->__refctr--;
+		if ((*iter)->__refctr == 0)
+			delete *iter;
+	}
+}
+
+/// Count (or uncount) the references by the holders
+void pin_held(tgc_visitf f)
+{
+	for (auto iter = __holders.begin(); iter != __holders.end(); iter++)
+		(*iter)->gc_held(f, this);
+}
+
+/// Release the deferred values not referred, the holders being pinned. The
+/// values they refer may be deferred in turn
+void release_deferred()
+{
+	while (!__deferred.empty()) {
+		std::vector<tcompo_v *> & deferred = __releasing;
+
+		deferred.swap(__deferred);
+		for (auto iter = deferred.begin(); iter != deferred.end(); iter++) {
+			tcompo_v * v = *iter;
+
+			if (v == nullptr)
+				continue;
+			v->__gcinfo &= ~uint32_t(Tap_GC_DEFERRED);
+			if (v->__refctr == 0)
+				delete v;
+			else if ((v->__gcinfo & Tap_GC_TRACED) && color(v) == Tap_GC_PURPLE)
+				possible_root(v); // deducted while deferred
+		}
+		deferred.clear();
+	}
+}
+
+/// Free the garbage cycles among the subgraphs of the possible roots, the
+/// holders being pinned
+uint64_t collect_cycles()
+{
+	std::vector<tcompo_v *> roots;
+	std::vector<tcompo_v *> whites;
+
+	roots.swap(__roots);
+	__ntraced = 0;
+	__cycles = false;
+	__stats.ncollects++;
+
+	// Mark: roots still purple and referred (the others are not buffered)
+	size_t nroots = 0;
+
+	for (auto iter = roots.begin(); iter != roots.end(); iter++) {
+		tcompo_v * v = *iter;
+
+		if (v == nullptr)
+			continue;
+		v->__gcinfo &= ~uint32_t(Tap_GC_BUFFERED);
+		if (color(v) == Tap_GC_PURPLE && v->__refctr > 0) {
+			mark_gray_from(v);
+			roots[nroots++] = v;
+		}
+		else if (color(v) == Tap_GC_PURPLE)
+			set_color(v, Tap_GC_BLACK);
+	}
+	roots.resize(nroots);
+	// Scan and collect
+	for (auto iter = roots.begin(); iter != roots.end(); iter++)
+		scan_from(*iter);
+	for (auto iter = roots.begin(); iter != roots.end(); iter++)
+		collect_white_from(*iter, whites);
+	free_whites(whites);
+	__stats.nfreed += whites.size();
+	return whites.size();
+}
+
+/// Release the deferred values, then collect the cycles if `cycles`
+uint64_t run(bool cycles)
+{
+	uint64_t nfreed = 0;
+
+	__nheld = 0;
+	pin_held(pin);
+	__ndeferred = std::max(static_cast<size_t>(Tap_GC_DEFERRED_MAX), __nheld);
+	release_deferred();
+	if (cycles)
+		nfreed = collect_cycles();
+	pin_held(unpin);
+	__due = __cycles;
+	return nfreed;
+}
+
+public:
+tgc()
+{
+	__threshold = Tap_GC_THRESHOLD;
+	__ntraced = 0;
+	__nheld = 0;
+	__ndeferred = Tap_GC_DEFERRED_MAX;
+	__due = false;
+	__cycles = false;
+	__stats = tgc_stats();
+}
+
+/// Release the deferred values left, no longer held
+~tgc()
+{
+	tgc * prev = enter();
+
+	release_deferred();
+	leave(prev == this ? nullptr : prev);
+}
+
+/// Collect the cycles of the values by this collector until `leave`
+/// @return the collector current before
+tgc * enter()
+{
+	tgc * prev = current();
+
+	current() = this;
+	return prev;
+}
+
+/// Make `prev`, returned by `enter`, current again
+static void leave(tgc * prev)
+{
+	current() = prev;
+}
+
+/// @return the collector of the values, a default one (never released) if
+/// none
+static tgc * get_current()
+{
+	tgc *& gc = current();
+
+	if (gc == nullptr) {
+		static Tap_SESSION_LOCAL tgc * fallback = nullptr;
+
+		if (fallback == nullptr)
+			fallback = new tgc();
+		gc = fallback;
+	}
+	return gc;
+}
+
+/// @return whether a collection of cycles, or a release, is due
+bool is_due() const
+{
+	return __due;
+}
+
+/// Trace `v` (see tcompo_v::gc_track)
+void track(tcompo_v * v)
+{
+	v->__gcinfo |= Tap_GC_TRACED;
+	__stats.ntraced++;
+	if (++__ntraced >= __threshold && __threshold != 0)
+		__due = __cycles = true;
+}
+
+/// Buffer `v` as a possible root of a cycle
+void possible_root(tcompo_v * v)
+{
+	set_color(v, Tap_GC_PURPLE);
+	if (v->__gcinfo & (Tap_GC_BUFFERED | Tap_GC_DEFERRED)) // buffered when released if deferred
+		return;
+	if (__roots.size() >= Tap_GC_MAXROOTS) { // buffered at its next deduction
+		__due = __cycles = true;
+		return;
+	}
+	v->__gcinfo = (v->__gcinfo & Tap_GC_FLAGS) | Tap_GC_BUFFERED | static_cast<uint32_t>(__roots.size() << 8);
+	__roots.push_back(v);
+	__stats.nbuffered++;
+	if (__roots.size() >= __threshold && __threshold != 0)
+		__due = __cycles = true;
+}
+
+/** Defer the release of `v`, held by temporary objects (see tgc_holder),
+ *  whose counter is 0: it is released at the next safe point unless held
+ *  by them, or referred again, by then
+ */
+void defer(tcompo_v * v)
+{
+	if (v->__gcinfo & Tap_GC_DEFERRED)
+		return;
+	if (v->__gcinfo & Tap_GC_BUFFERED)
+		unbuffer(v);
+	v->__gcinfo = (v->__gcinfo & Tap_GC_FLAGS & ~uint32_t(Tap_GC_BUFFERED)) | Tap_GC_DEFERRED
+		| static_cast<uint32_t>(__deferred.size() << 8); // unlocated beyond 2^24, see unbuffer
+	__deferred.push_back(v);
+	__stats.ndeferred++;
+	if (__deferred.size() >= __ndeferred) // amortizing the visits of the values held
+		__due = true;
+}
+
+/// Remove `v`, being freed, from the possible roots, or the deferred values
+void unbuffer(tcompo_v * v)
+{
+	std::vector<tcompo_v *> & buffer = (v->__gcinfo & Tap_GC_DEFERRED) ? __deferred : __roots;
+	uint32_t loc = v->__gcinfo >> 8;
+
+	if (loc < buffer.size() && buffer[loc] == v)
+		buffer[loc] = nullptr;
+}
+
+/// Add a holder of values not counted
+void add_holder(tgc_holder * holder)
+{
+	__holders.push_back(holder);
+}
+
+/// Remove a holder of values not counted
+void rm_holder(tgc_holder * holder)
+{
+	for (auto iter = __holders.begin(); iter != __holders.end(); iter++)
+		if (*iter == holder) {
+			__holders.erase(iter);
+			return;
+		}
+}
+
+/** Free the garbage cycles among the subgraphs of the possible roots, and
+ *  release the deferred values no longer referred
+ *  @details Must be called while all the values referred, but not counted,
+ *  are held by the holders, e.g. between two bycodes run by tvm.
+ *  @return the number of values of cycles freed
+ */
+uint64_t collect()
+{
+	return run(true);
+}
+
+/// Run the collection due (see is_due), at a safe point as `collect`
+void collect_due()
+{
+	run(__cycles);
+}
+
+/// Release the deferred values no longer referred, at a safe point as
+/// `collect`
+void release()
+{
+	if (!__deferred.empty())
+		run(false);
+}
+
+/// Set the number of traced values allocated, or buffered, between two
+/// collections (0: collect only on demand)
+void set_threshold(uint64_t threshold)
+{
+	__threshold = threshold;
+	__cycles = threshold != 0 && (__ntraced >= threshold || __roots.size() >= threshold);
+	__due = __cycles || __deferred.size() >= __ndeferred;
+}
+
+/// @return the number of traced values allocated, or buffered, between two
+/// collections
+uint64_t get_threshold() const
+{
+	return __threshold;
+}
+
+/// @return the statistics of this collector
+const tgc_stats & get_stats() const
+{
+	return __stats;
+}
+
+/// Visit the composite value of `v` if it is
+static void visit(const tobj & v, tgc_visitf f, void * arg)
+{
+	if (v.get_type() == tcompo)
+		f(v.get_v_tcompo(), arg);
+}
+
+};
+
+inline void tcompo_v::gc_possible_root()
+{
+	tgc::get_current()->possible_root(this);
+}
+
+inline void tcompo_v::gc_unbuffer()
+{
+	tgc::get_current()->unbuffer(this);
+}
+
+Tap_NOINLINE inline void tcompo_v::gc_defer()
+{
+	tgc::get_current()->defer(this);
+}
+
+inline void tcompo_v::gc_track()
+{
+	tgc::get_current()->track(this);
+}
+
 
 /// Two objects as a pair where two `datas` and `types` are maintained
 class tobj_pair
@@ -536,6 +1609,13 @@ void set_second(const tobj & v)
 	__second.set_v(v);
 }
 
+/// Drop the references to the elements, set to nil
+void clear_pair()
+{
+	__first.ddc_ref_clear();
+	__second.ddc_ref_clear();
+}
+
 /// Generate a string of the pair (`first` : `second`)
 std::string tostring_pair() const
 {
@@ -549,11 +1629,16 @@ std::string tostring_pair() const
 };
 
 
-/// Wrapper of array of tobjs
+/** Wrapper of array of tobjs
+ *  @details The locations of the names of the objects in the constant list of
+ *  strings are kept aside of the objects, so that the objects are values only,
+ *  and only if required (see keep_names).
+ */
 class tobj_array
 {
 private:
 	tobj * __objlst;
+	uint_size_cst * __namelst;  ///< names of the objects in __objlst
 	uint_size_obj __objlst_cap;
 	uint_size_obj __objlst_len;
 
@@ -563,6 +1648,7 @@ tobj_array(uint_size_obj objlst_cap)
 	__objlst_cap = objlst_cap;
 	__objlst_len = 0;
 	__objlst = new tobj[objlst_cap];
+	__namelst = nullptr;
 }
 
 virtual
@@ -574,6 +1660,15 @@ virtual
 		iter->ddc_ref_clear();
 	}
 	delete [] __objlst;
+	if (__namelst != nullptr)
+		delete [] __namelst;
+}
+
+/// Keep the names of the objects from now on (for listing the objects)
+void keep_names()
+{
+	if (__namelst == nullptr)
+		__namelst = new uint_size_cst[__objlst_cap]();
 }
 
 /// Try to expand the object array if the room is not enough.
@@ -585,6 +1680,12 @@ void try_expand_objlist(uint_size_obj obj_max)
 		std::copy(__objlst, __objlst + __objlst_len, new_objlst);
 		delete [] __objlst;
 		__objlst = new_objlst;
+		if (__namelst != nullptr) {
+			uint_size_cst * new_namelst = new uint_size_cst[obj_max]();
+			std::copy(__namelst, __namelst + __objlst_len, new_namelst);
+			delete [] __namelst;
+			__namelst = new_namelst;
+		}
 		__objlst_cap = obj_max;
 	}
 }
@@ -616,7 +1717,8 @@ uint_size_obj get_ref_obj_loc(tcompo_v * pv) const
 /// Decleare an object
 void add_obj(uint_size_cst nameloc = UNDEF_NAMELOC)
 {
-	__objlst[__objlst_len].set_name_loc(nameloc);
+	if (__namelst != nullptr)
+		__namelst[__objlst_len] = nameloc;
 	__objlst_len++;
 }
 
@@ -642,17 +1744,56 @@ void set_objlst_len(uint_size_obj nleft)
 	__objlst_len = nleft;
 }
 
+/// Swap the object list with `objlst` of length `len`, whose capability
+/// should be the same. Used for the activations of functions, whose objects
+/// have the same names, so that __namelst is kept.
+void swap_objlst(tobj *& objlst, uint_size_obj & len)
+{
+	std::swap(__objlst, objlst);
+	std::swap(__objlst_len, len);
+}
+
+/// Move the `len` objects of `objlst` to the end of the object list, their
+/// references with them: those of `objlst` are set to nil
+void move_objs(tobj * objlst, uint_size_obj len)
+{
+	for (uint_size_obj i = 0; i < len; i++) {
+		__objlst[__objlst_len++] = objlst[i];
+		objlst[i].set_nil();
+	}
+}
+
+/// Visit the composite objects in the object array (see tgc)
+void traverse_objs(tgc_visitf f, void * arg)
+{
+	for (uint_size_obj i = 0; i < __objlst_cap; i++)
+		tgc::visit(__objlst[i], f, arg);
+}
+
+/// Drop the references to the objects in the object array, set to nil
+void clear_objs()
+{
+	for (uint_size_obj i = 0; i < __objlst_cap; i++)
+		__objlst[i].ddc_ref_clear();
+}
+
 bool has_obj(uint_size_cst nameloc)
 {
+	if (__namelst == nullptr)
+		return false;
 	for (uint16_t i = 0; i<__objlst_len; i++) {
-		tobj vi = __objlst[i];
-
-		if (vi.get_name_loc() == nameloc)
+		if (__namelst[i] == nameloc)
 			return true;
 	}
 	return false;
 }
 
+/// @return location of the name of the object at `n` in constant strings
+uint_size_cst get_name_loc(uint_size_obj n) const
+{
+	return __namelst == nullptr ? UNDEF_NAMELOC : __namelst[n];
+}
+
 /// @return the object located at `n`
 tobj & get_obj(uint_size_obj n)
 {
@@ -684,12 +1825,30 @@ void set_obj(uint_size_obj loc, const tobj & v)
 class tpair : public tcompo_v, public tobj_pair
 {
 public:
+Tap_COMPO_ALLOC(compo_tpair)
+
 /// Constructor
-tpair(const tobj & first, const tobj & second) : tobj_pair(first, second) {}
+tpair(const tobj & first, const tobj & second) : tobj_pair(first, second)
+{
+	gc_track();
+}
 
 /// Deconstructor
 ~tpair() {}
 
+/// Visit the elements (see tgc)
+void gc_traverse(tgc_visitf f, void * arg)
+{
+	tgc::visit(get_first(), f, arg);
+	tgc::visit(get_second(), f, arg);
+}
+
+/// Drop the elements (see tgc)
+void gc_clear()
+{
+	clear_pair();
+}
+
 /// Generate a string "Pair"
 const char * get_type() const
 {
@@ -1037,6 +2196,71 @@ virtual bool in(const tobj & e) = 0;        ///< e in iterator
 virtual void iter_restore() = 0;            ///< loc = 0
 };
 
+/** Operator table of the interface `I` (top_add, ..., tcompo_idx,
+ *  tcompo_iter), indexed by the code of composite types
+ *  @details An entry casts a value of its type to `I`, so that dispatching an
+ *  operator is an indexed load and an indirect call instead of the RTTI walk
+ *  of dynamic_cast. Types not registered (see tcompo_register) are still
+ *  casted by dynamic_cast.
+ */
+template <class I>
+struct tcompo_ops
+{
+	typedef I * (* castf)(tcompo_v *);
+	static castf table[UINT8_MAX + 1];
+
+	/// @return `v` as `I`, or nullptr if its type does not provide `I`
+	static I * cast(tcompo_v * v)
+	{
+		castf f = table[v->get_compo_type_code()];
+		return f != nullptr ? f(v) : dynamic_cast<I *>(v);
+	}
+};
+
+template <class I>
+typename tcompo_ops<I>::castf tcompo_ops<I>::table[UINT8_MAX + 1] = {};
+
+/// Cast of composite type `T` to the interface `I` (nullptr if not provided)
+template <class T, class I, bool = std::is_base_of<I, T>::value>
+struct tcompo_caster
+{
+	static I * cast(tcompo_v * v) { return static_cast<T *>(v); }
+};
+
+template <class T, class I>
+struct tcompo_caster<T, I, false>
+{
+	static I * cast(tcompo_v *) { return nullptr; }
+};
+
+/// Fill the entries `code` of the operator tables of `Is` for type `T`
+template <class T>
+inline void tcompo_register_ops(uint8_t) {}
+
+template <class T, class I, class... Is>
+inline void tcompo_register_ops(uint8_t code)
+{
+	tcompo_ops<I>::table[code] = &tcompo_caster<T, I>::cast;
+	tcompo_register_ops<T, Is...>(code);
+}
+
+/** Register composite type `T` returning `code` by get_compo_type_code() to
+ *  the operator tables. User types take codes from `compo_user` on, each one
+ *  its own: the entries of a code cast any value of this code as `T`, so that
+ *  a code registered by another type is an error.
+ */
+template <class T>
+inline void tcompo_register(uint8_t code)
+{
+	typename tcompo_ops<tcompo_idx>::castf owner = tcompo_ops<tcompo_idx>::table[code];
+
+	if (owner != nullptr && owner != &tcompo_caster<T, tcompo_idx>::cast)
+		twarn(ErrRuntime_RefType).warn("tcompo_register", "type code registered by another type");
+	tcompo_register_ops<T, top_add, top_sub, top_mul, top_div, top_mod,
+		top_mmul, top_pow, top_eq, top_ne, top_sg, top_sl, top_ge,
+		top_le, top_and, top_or, tcompo_idx, tcompo_iter>(code);
+}
+
 /// Iterator in Tap. Created by `v1 to v2` (to expression)
 class titer : public tcompo_v
 {
@@ -1047,6 +2271,8 @@ private:
 	long __end;
 
 public:
+Tap_COMPO_ALLOC(compo_titer)
+
 /// Constructor of iterator (start to end by middle)
 titer(const long start, const long middle, const long end)
 {
@@ -1204,6 +2430,8 @@ private:
 	uint_size_stk __nparams;
 
 public:
+Tap_COMPO_ALLOC(compo_cppfunc)
+
 /// Constructor: a wrapper of cppf `f`
 tcppgenf(const cppf & f, const char * name, uint_size_stk nparams)
 {
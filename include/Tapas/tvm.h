@@ -4,6 +4,13 @@
 #include "tenv.h"
 #include "extensions/teigen.h"
 
+/// Bycodes are dispatched by direct threading (computed goto) if the compiler
+/// supports labels as values (GCC, Clang). Define `Tap_SWITCH_DISPATCH` to use
+/// the portable `switch` dispatch loop instead.
+#if defined(__GNUC__) && !defined(Tap_SWITCH_DISPATCH)
+#define Tap_THREADED_DISPATCH
+#endif
+
 namespace tapas
 {
 
@@ -59,7 +66,7 @@ inline void operator_in(const tobj & v1, const tobj & v2, tobj & vre)
 			operator_in_basic<tlist>(v1, v2_tlist, vre);
 			return;  // return if passing through
 		}
-		tcompo_iter * v2_iterable = dynamic_cast<tcompo_iter *>(v2_compo_v);
+		tcompo_iter * v2_iterable = tcompo_ops<tcompo_iter>::cast(v2_compo_v);
 
 		if (v2_iterable != nullptr) {
 			operator_in_basic<tcompo_iter>(v1, v2_iterable, vre);
@@ -100,7 +107,7 @@ inline void op_compo_extended(const std::string & fname,
 		twarn(ErrRuntime_ParamsType).warn(fname, v1.tostring_full() + op + v2.tostring_full());
 	if (type_v1 == tcompo) {
 		tcompo_v * v1_compo = v1.get_v_tcompo();
-		T * p = dynamic_cast<T *>(v1_compo);
+		T * p = tcompo_ops<T>::cast(v1_compo);
 
 		if (p != nullptr) {
 			op_compo_basic(v2, vre, p, f1);
@@ -110,7 +117,7 @@ inline void op_compo_extended(const std::string & fname,
 	}
 	if (type_v2 == tcompo) {
 		tcompo_v * v2_compo = v2.get_v_tcompo();
-		T * p = dynamic_cast<T *>(v2_compo);
+		T * p = tcompo_ops<T>::cast(v2_compo);
 
 		if (p != nullptr) {
 			op_compo_basic(v1, vre, p, f2);
@@ -288,7 +295,7 @@ inline void operator_eq(const tobj & v1, const tobj & v2, tobj & vre)
 {
 	if (v1.get_type() == tcompo) {
 		tcompo_v * v1_compo = v1.get_v_tcompo();
-		top_eq * p = dynamic_cast<top_eq *>(v1_compo);
+		top_eq * p = tcompo_ops<top_eq>::cast(v1_compo);
 
 		if (p != nullptr) {
 			op_compo_basic(v2, vre, p, &top_eq::operator_eq);
@@ -297,7 +304,7 @@ inline void operator_eq(const tobj & v1, const tobj & v2, tobj & vre)
 	}
 	if (v2.get_type() == tcompo) {
 		tcompo_v * v2_compo = v2.get_v_tcompo();
-		top_eq * p = dynamic_cast<top_eq *>(v2_compo);
+		top_eq * p = tcompo_ops<top_eq>::cast(v2_compo);
 
 		if (p != nullptr) {
 			op_compo_basic(v1, vre, p, &top_eq::operator_req);
@@ -315,7 +322,7 @@ operator_ne(const tobj & v1, const tobj & v2, tobj & vre)
 {
 	if (v1.get_type() == tcompo) {
 		tcompo_v * v1_compo = v1.get_v_tcompo();
-		top_ne * p = dynamic_cast<top_ne *>(v1_compo);
+		top_ne * p = tcompo_ops<top_ne>::cast(v1_compo);
 
 		if (p != nullptr) {
 			op_compo_basic(v2, vre, p, &top_ne::operator_ne);
@@ -324,7 +331,7 @@ operator_ne(const tobj & v1, const tobj & v2, tobj & vre)
 	}
 	if (v2.get_type() == tcompo) {
 		tcompo_v * v2_compo = v2.get_v_tcompo();
-		top_ne * p = dynamic_cast<top_ne *>(v2_compo);
+		top_ne * p = tcompo_ops<top_ne>::cast(v2_compo);
 
 		if (p != nullptr) {
 			op_compo_basic(v1, vre, p, &top_ne::operator_rne);
@@ -467,28 +474,230 @@ inline void operator_or(const tobj & v1, const tobj & v2, tobj & vre)
  * 4. Virtual machine
  *===========================================================================*/
 
+/** A call frame of tvm
+ *  @details The state of the caller, saved when a Tapas function (or an
+ *           imported library) starts running above it in the value stack.
+ *           If the function is already running, the locals of its running
+ *           activation are saved as well, while the new activation keeps
+ *           its locals in the frame.
+ */
+struct tframe
+{
+	tcompo_env     * env;      ///< environment of the caller
+	tbycode        * ret;      ///< calling bycode (return address)
+	tbycode        * end;      ///< end of the bycodes of the caller
+	const twrapper * wrapper;  ///< wrapper of the caller
+	tobj           * top;      ///< top of vmstack of the caller
+	tobj           * args;     ///< parameters and callee, replaced by the returned value
+	tobj           * stk;      ///< vmstack of the caller
+	tobj           * tmps;     ///< temporary objects of the caller
+	uint_size_obj    ntmps;    ///< number of temporary objects of the caller
+	tobj           * locals;   ///< locals of the running activation of callee
+	uint_size_obj    nlocals;  ///< number of locals of the running activation
+};
+
 /** The tvm class
- *  @details This class execute the bycodes on the imported vmstack from
- *           environment and get the returned value.
+ *  @details This class execute the bycodes and get the returned value.
+ *           All the call frames share one contiguous value stack, each of
+ *           which holds the temporary objects and then the registers
+ *           (vmstack) of a running environment. The references of the
+ *           registers are not counted: they are held for the cycle
+ *           collector (see tgc_holder).
  */
-class tvm : tobj_array
+class tvm : public tgc_holder
 {
 private:
-	/// Runtime: maximum registers in vmstack
-	uint_size_stk __regmax;
+	/// Runtime: cycle collector of the values
+	tgc * __gc;
+
+	/// Runtime: value stack shared by the call frames
+	tobj * __vstk;
+
+	/// Runtime: call frames of the callers
+	std::vector<tframe> __frames;
 
-	/// Runtime: not created by tvm
+	/// Runtime: temporary objects of the current frame
+	tobj * __tmps;
+	uint_size_obj __ntmps;
+
+	/// Runtime: maximum temporary objects of the bottom frame
+	uint_size_obj __tmpmax;
+
+	/// Runtime: vmstack of the current frame
 	tobj * __stk;
 	uint_size_stk __stklen;
 
 	/// Runtime: returned value
 	tobj __rev;
 
-	/// Runtime: in the layer of loops
-	uint_size_stk __inloop;
+/// Decleare a temporary object
+void add_obj()
+{
+	__ntmps++;
+}
+
+/// Delete `n` temporary objects
+void del_obj(uint_size_obj n)
+{
+	while (n > 0) {
+		__ntmps--;
+		clear_tmp(__tmps[__ntmps]);
+		n--;
+	}
+}
+
+/// @return the temporary object located at `loc`
+tobj & get_obj(uint_size_obj loc)
+{
+	return __tmps[loc];
+}
+
+/** Set the temporary object at `loc` to be `v`
+ *  @details Like the registers, the temporary objects do not count their
+ *  references: a value held by them is released at a safe point (see tgc).
+ */
+void set_obj(uint_size_obj loc, const tobj & v)
+{
+	ttypes vtype = v.get_type();
+	tobj & vloc = get_obj(loc);
+
+	if (vtype == tnil)
+		twarn(ErrRuntime_AssignNil).warn("tvm::set_obj", "");
+	if (vtype == tcompo) {
+		// check self assigment: a = a
+		if (vloc.get_type() == tcompo && vloc.get_v_tcompo() == v.get_v_tcompo())
+			return;
+		v.get_v_tcompo()->gc_hold();
+	}
+	clear_tmp(vloc);
+	vloc.set_v(v);
+}
+
+/// Clean the temporary object `v` (see tcompo_v::drop_held)
+static void clear_tmp(tobj & v)
+{
+	if (v.get_type() == tcompo)
+		v.get_v_tcompo()->drop_held();
+	v.set_nil();
+}
+
+/** Start a new frame above the top of vmstack of `caller`
+ *  @param caller  - state of the caller, whose vmstack fields are filled here
+ *  @param nlocals - the number of locals kept in the new frame
+ *  @param tmpmax  - the maximum number of temporary objects of the new frame
+ *  @param regmax  - the maximum number of registers of the new frame
+ */
+void enter_frame(tframe caller, uint_size_obj nlocals, uint_size_obj tmpmax, uint_size_stk regmax)
+{
+	if (caller.top + nlocals + tmpmax + regmax > __vstk + VMSTACK_SIZE_LIMIT)
+		twarn(ErrRuntime_StackOverflow).warn("tvm::enter_frame", "");
+	caller.stk = __stk;
+	caller.tmps = __tmps;
+	caller.ntmps = __ntmps;
+	__frames.push_back(caller);
+	__tmps = caller.top + nlocals;
+	__ntmps = 0;
+	__stk = __tmps + tmpmax;
+	__stklen = 0;
+
+	// registers popped without cleaning may be left there
+	for (tobj * v = caller.top; v < __stk; v++)
+		v->set_nil();
+}
+
+/** Leave the current frame: clean its registers below `top` and its
+ *  temporary objects, and restore vmstack of the caller
+ *  @return state of the caller
+ */
+tframe leave_frame(tobj * top)
+{
+	while (top > __stk)
+		(--top)->try_clear();
+	del_obj(__ntmps);
+
+	tframe caller = __frames.back();
+	__frames.pop_back();
+	__tmps = caller.tmps;
+	__ntmps = caller.ntmps;
+	__stk = caller.stk;
+	__stklen = static_cast<uint_size_stk>(caller.top - __stk);
+	return caller;
+}
+
+/** Start an activation of `f` called by `caller` on a new frame
+ *  @details An activation of a running function keeps its locals in the
+ *           frame, so that the function is re-entrant. If functions are
+ *           created in `f`, which read its locals, it runs on a copy of `f`
+ *           instead. The environment is referred while running.
+ *  @return the environment of the activation
+ */
+tfunc * enter_tfunc(tfunc * f, const tframe & caller)
+{
+	if (f->get_nactive() == 0)
+		enter_frame(caller, 0, f->get_tmpmax(), f->get_regmax());
+	else if (f->is_captured()) {
+		enter_frame(caller, 0, f->get_tmpmax(), f->get_regmax());
+		f = f->copy();
+		f->set_activation();
+	} else {
+		tobj * locals = caller.top;
+		uint_size_obj nlocals = 0;
+
+		enter_frame(caller, f->get_objlst_cap(), f->get_tmpmax(), f->get_regmax());
+		f->swap_objlst(locals, nlocals);
+		__frames.back().locals = locals;
+		__frames.back().nlocals = nlocals;
+	}
+	f->activate();
+	f->add_refctr();
+	return f;
+}
+
+/** Stop the activation of `f` on the current frame, see `leave_frame`
+ *  @return state of the caller
+ */
+tframe leave_tfunc(tfunc * f, tobj * top)
+{
+	tframe caller = leave_frame(top);
 
-	/// Compilation
-	std::vector<std::string> __paths;
+	if (caller.locals != nullptr) {
+		f->tobj_array::del_obj(f->get_objlst_len());
+		f->swap_objlst(caller.locals, caller.nlocals);
+	}
+	f->deactivate();
+	if (f->ddc_refctr() == 0 && f->is_activation())
+		f->release();
+	return caller;
+}
+
+/** Give the running activation of `f` an environment of its own, before a
+ *  closure captures it
+ *  @details The locals of an activation of a running function are in its
+ *           frame, and in `f` only while it runs (see enter_tfunc): a closure
+ *           capturing `f` would read those of another activation once it
+ *           returns. The locals are moved to a copy of `f`, which runs the
+ *           rest of the activation and stays with the closures, and `f` gets
+ *           back the locals of the activation below.
+ *  @return the copy of `f`, the environment of the running activation
+ */
+tfunc * own_activation(tfunc * f)
+{
+	tframe & frame = __frames.back();
+	tfunc * act = f->copy();
+
+	act->set_activation();
+	f->swap_objlst(frame.locals, frame.nlocals);
+	act->move_objs(frame.locals, frame.nlocals);
+	act->set_dynamic_nparams(f->get_dynamic_nparams());
+	act->set_params(f->get_params());
+	frame.locals = nullptr;
+	frame.nlocals = 0;
+	f->deactivate();
+	f->ddc_refctr();
+	act->activate();
+	act->add_refctr();
+	return act;
+}
 
 /// Remove the contents of __rev without cleaning it
 void set_rev_empty()
@@ -593,6 +802,9 @@ void parse_idx(const uint_size_stk nparams)
 	case compo_tdict:
 		parse_idx_basic(nparams, reinterpret_cast<tdict *>(arr), obj);
 		break;
+	case compo_trecord:
+		parse_idx_basic(nparams, reinterpret_cast<trecord *>(arr), obj);
+		break;
 	case compo_tlist:
 		parse_idx_basic(nparams, reinterpret_cast<tlist *>(arr), obj);
 		break;
@@ -610,7 +822,7 @@ void parse_idx(const uint_size_stk nparams)
 		break;
 	default:
 		tcompo_idx * ptype = nullptr;
-		if (nullptr == (ptype = dynamic_cast<tcompo_idx *>(arr)))
+		if (nullptr == (ptype = tcompo_ops<tcompo_idx>::cast(arr)))
 			twarn(ErrRuntime_RefType).warn("tvm::parse_idx", "Un-indexable");
 		parse_idx_basic(nparams, ptype, obj);
 	}
@@ -641,16 +853,13 @@ void parse_eval(tbycode * iter, tcompo_env * env)
 	tcompo_v * v = obj.get_v_tcompo();
 
 	switch (v->get_compo_type_code()) {
-	case compo_tfunc:
-		parse_eval_tf(v, params, nparams, env);
-		break;
 	case compo_cppfunc:
 		reinterpret_cast<tcppgenf *>(v)->get_f()(params, nparams, __rev);
-		iter->set_ins(OP_EVALCF); // cppfunc cannot be re-assigned values
+		iter->set_ins(OP_EVALCF); // runtime optimiztion of bycodes
 		break;
 	case compo_sessfunc:
 		reinterpret_cast<tcppsessf *>(v)->get_f()(params, nparams, __rev, env);
-		iter->set_ins(OP_EVALSF); // sessfunc cannot be re-assigned values
+		iter->set_ins(OP_EVALSF); // runtime optimiztion of bycodes
 		break;
 	default: ;
 	}
@@ -659,28 +868,6 @@ void parse_eval(tbycode * iter, tcompo_env * env)
 	set_rev_empty();
 }
 
-/// OP_EVALTF (Not yet)
-void parse_eval_tf(tcompo_v * v, tobj * params, uint_size_stk nparams, tcompo_env * env)
-{
-	tfunc * f = reinterpret_cast<tfunc *>(v);
-	// check environment tree looping (recursion)
-	if (f == env)
-		twarn(ErrRuntime_EnvInconsis).warn("tvm::eval_tfunc", "");
-	// check parameter number
-	if (f->get_nparams() != UNDEF_NPARAMS && nparams != f->get_nparams())
-		twarn(ErrRuntime_ParamsCtr).warn("tvm::eval_tfunc", "1");
-	// create new virtual machine
-	tvm new_vm(f->get_tmpmax());
-	new_vm.set_vmstack(f->get_vmstack(), f->get_regmax());
-	// execution
-	f->assign_params(params, nparams);
-	new_vm.exec_tins(f->get_cmdloc(), f->get_ncmds(), f);
-	// get returned value
-	__rev = new_vm.get_vre();
-	new_vm.set_rev_empty();
-	new_vm.set_vmstack(nullptr, 0);
-}
-
 /// OP_IMPORT
 void parse_import(const uint_size_cst cloc, char ** const clst, tcompo_env * const env)
 {
@@ -696,27 +883,33 @@ void parse_import(const uint_size_cst cloc, char ** const clst, tcompo_env * con
 	// initialize the new lib
 	lib->set_wrapper(w);
 
-	tvm vm(w->info.tmp_max);
-	vm.set_vmstack(lib->get_vmstack(), w->info.reg_max);
+	// excute imported file in new lib, on a new frame above vmstack
+	tobj * top = __stk + __stklen;
+	enter_frame({env, nullptr, nullptr, nullptr, top, top, nullptr, nullptr, 0, nullptr, 0},
+		0, w->info.tmp_max, w->info.reg_max);
 
 	try {
-		vm.exec_tins(0, w->ncmds, lib); // excute imported file in new lib
+		exec_tins(0, w->ncmds, lib);
 	} catch (...) {
-		vm.clean();
+		__rev.try_clear();
+		leave_frame(__stk + __stklen);
 		delete lib;
 		twarn(ErrRuntime_Other).warn("tvm::parse_import", file);
 	}
 
-	tobj returned_v = vm.get_vre();
-	vm.set_rev_empty();         // strip vm->rev
-	vm.clean();                 // clean vm stack
-	vm.set_vmstack(nullptr, 0); // strip lib->vmstack
+	tobj returned_v = __rev;
+	set_rev_empty();                // strip vm->rev
+	leave_frame(__stk + __stklen);  // clean the frame of lib
 
 	if (returned_v.get_type() == tcompo) {
 		tcompo_v * v = returned_v.get_v_tcompo();
 
 		if (v->get_compo_type_code() == compo_tdict)
 			lib->set_exposed(reinterpret_cast<tdict *>(v));
+		else if (v->get_compo_type_code() == compo_trecord) {
+			lib->set_exposed(reinterpret_cast<trecord *>(v)->todict());
+			returned_v.try_clear();
+		}
 		else {
 			delete v;
 			lib->set_exposed(new tdict());
@@ -728,11 +921,41 @@ void parse_import(const uint_size_cst cloc, char ** const clst, tcompo_env * con
 	topfree_filled();
 }
 
+/** Look up the constant key of `cache` in `obj` (see tlib::bind_keys)
+ *  @param lib whether the value is only read, and then looked up in a library
+ *  as well; otherwise the value is to be set (see tdict::find_cached)
+ *  @param keyed set to whether `obj` is a dict or a record, or a library if `lib`
+ *  @return the value of the key, or nullptr if absent (or not `keyed`)
+ */
+static tobj * find_keyed(const tobj & obj, bool lib, tkeycache & cache, const char * key, bool & keyed)
+{
+	keyed = false;
+	if (obj.get_type() != tcompo)
+		return nullptr;
+	tcompo_v * v = obj.get_v_tcompo();
+
+	switch (v->get_compo_type_code()) {
+	case compo_tdict:
+		keyed = true;
+		return reinterpret_cast<tdict *>(v)->find_cached(cache, key, !lib);
+	case compo_trecord:
+		keyed = true;
+		return reinterpret_cast<trecord *>(v)->find_cached(cache, key, !lib);
+	case compo_tlib:
+		if (!lib)
+			return nullptr;
+		keyed = true;
+		return reinterpret_cast<tlib *>(v)->get_exposed()->find_cached(cache, key, false);
+	default:
+		return nullptr;
+	}
+}
+
 /// OP_IDXL
 void parse_idxl(const uint_size_obj loc, const uint_size_stk nparams,
-		bool isenv, tcompo_env * env)
+		uint_size_obj ienv, tcompo_env * env)
 {
-	tobj & obj = isenv ? env->get_obj(loc) : get_obj(loc);
+	tobj & obj = locate_obj(loc, ienv, env);
 
 	if (obj.get_type() != tcompo)
 		twarn(ErrRuntime_RefType).warn("tvm::parse_idxl", "");
@@ -748,6 +971,9 @@ void parse_idxl(const uint_size_obj loc, const uint_size_stk nparams,
 	case compo_tdict:
 		parse_idxl_basic(nparams, reinterpret_cast<tdict *>(arr));
 		break;
+	case compo_trecord:
+		parse_idxl_basic(nparams, reinterpret_cast<trecord *>(arr));
+		break;
 	case compo_tlist:
 		parse_idxl_basic(nparams, reinterpret_cast<tlist *>(arr));
 		break;
@@ -758,7 +984,7 @@ void parse_idxl(const uint_size_obj loc, const uint_size_stk nparams,
 		parse_idxl_basic(nparams, reinterpret_cast<tdarr *>(arr));
 		break;
 	default:
-		tcompo_idx * arrx = dynamic_cast<tcompo_idx *>(arr);
+		tcompo_idx * arrx = tcompo_ops<tcompo_idx>::cast(arr);
 		if (arrx == nullptr)
 			twarn(ErrRuntime_RefType).warn("tvm::parse_idxl", "");
 		tobj & rv = vmstk_at(nparams);
@@ -785,7 +1011,7 @@ void parse_idxl_basic(const uint_size_stk nparams, T * arr)
 void parse_loopas(tbycode * iter, tobj & vre, tcompo_env * const env)
 {
 	uint_size_obj idx = iter->get_L();
-	bool isenv = iter->get_R();
+	uint_size_obj ienv = iter->get_R();
 
 	// Get the iterator (list, titer, ...)
 	const tobj & viter = vmstk_top();
@@ -795,20 +1021,20 @@ void parse_loopas(tbycode * iter, tobj & vre, tcompo_env * const env)
 
 	switch (it->get_compo_type_code()) {
 	case compo_titer:
-		parse_loopas_basic(reinterpret_cast<titer *>(it), idx, vre, isenv, env);
+		parse_loopas_basic(reinterpret_cast<titer *>(it), idx, vre, ienv, env);
 		iter->set_ins(OP_LOOPIAS);  // runtime optimiztion of bycodes
 		break;
 	case compo_tlist:
-		parse_loopas_basic(reinterpret_cast<tlist *>(it), idx, vre, isenv, env);
+		parse_loopas_basic(reinterpret_cast<tlist *>(it), idx, vre, ienv, env);
 		iter->set_ins(OP_LOOPLAS);  // runtime optimiztion of bycodes
 		break;
 	default:
 		tcompo_iter * pgiter = nullptr;
 
-		if (nullptr == (pgiter = dynamic_cast<tcompo_iter *>(it))) {
+		if (nullptr == (pgiter = tcompo_ops<tcompo_iter>::cast(it))) {
 			twarn(ErrRuntime_RefType).warn("tvm::parse_loopas", "");
 		}
-		parse_loopas_basic(pgiter, idx, vre, isenv, env);
+		parse_loopas_basic(pgiter, idx, vre, ienv, env);
 		iter->set_ins(OP_LOOPGAS);  // runtime optimiztion of bycodes
 	}
 }
@@ -816,530 +1042,1061 @@ void parse_loopas(tbycode * iter, tobj & vre, tcompo_env * const env)
 /// Set 'vre = p->next()' and 'p->get_v_at_loc(env[vloc]/__tmps[vloc])'
 template<typename T>
 void parse_loopas_basic(T * p, uint_size_obj vloc, tobj & vre,
-			bool isenv, tcompo_env * const env)
+			uint_size_obj ienv, tcompo_env * const env)
 {
 	vre.set_v(bool(p->next()));
 	tobj v;
 	p->get_v_at_loc(v);
 
-	if (isenv)
-		env->set_obj(vloc, v);
+	if (ienv)
+		env->set_obj_at(ienv - 1, vloc, v);
 	else
 		set_obj(vloc, v);
 }
 
-/// OP_ADD : OP_OR
-/// @details ee tcp::binop_split and tcp::parse_binop for the types
-void parse_binop(const binopf & f, tbycode * iter,
-			uint_size_stk type, tcompo_env * const env)
+/** @return the object at `loc`, a temporary object if `ienv` is 0,
+ *  otherwise an object of the environment `ienv - 1` levels above `env`
+ */
+tobj & locate_obj(uint_size_obj loc, uint_size_obj ienv, tcompo_env * const env)
 {
-	uint16_t left = iter->get_L();
-	uint16_t right = iter->get_R();
+	return ienv ? env->get_obj_at(ienv - 1, loc) : get_obj(loc);
+}
 
-	switch (type) {
-	case 0: // value value
-		f(vmstk_at(static_cast<uint_size_stk>(left)),
-		  vmstk_at(static_cast<uint_size_stk>(right)),
-		  vmstk_at(static_cast<uint_size_stk>(right)));
-		vmstk_pop_clean_front();
-		break;
-	case 1: // env value
-		f(env->get_obj(left),
-		  vmstk_at(static_cast<uint_size_stk>(right)),
-		  vmstk_at(static_cast<uint_size_stk>(right)));
-		break;
-	case 2: // value env
-		f(vmstk_at(static_cast<uint_size_stk>(left)),
-		  env->get_obj(right),
-		  vmstk_at(static_cast<uint_size_stk>(left)));
-		break;
-	case 3: // env env
-		f(env->get_obj(left), env->get_obj(right), topfree_rv());
-		topfree_filled();
-		break;
-	case 4: // tmp value
-		f(get_obj(left),
-		  vmstk_at(static_cast<uint_size_stk>(right)),
-		  vmstk_at(static_cast<uint_size_stk>(right)));
-		break;
-	case 5: // value tmp
-		f(vmstk_at(static_cast<uint_size_stk>(left)),
-		  get_obj(right),
-		  vmstk_at(static_cast<uint_size_stk>(left)));
-		break;
-	case 6: // tmp tmp
-		f(get_obj(left), get_obj(right), topfree_rv());
-		topfree_filled();
-		break;
-	case 7: // env tmp
-		f(env->get_obj(left), get_obj(right), topfree_rv());
-		topfree_filled();
-		break;
-	case 8: // tmp env
-		f(get_obj(left), env->get_obj(right), topfree_rv());
-		topfree_filled();
-		break;
+/// @return the environmental object of operand `loc` of LRk bycodes
+static tobj & locate_obj_lrk(uint16_t loc, tcompo_env * const env)
+{
+	return env->get_obj_at(ENVLOC_LRk_HOPS(loc), ENVLOC_LRk_SLOT(loc));
+}
+
+/** Locate the operands `v1`, `v2` and the result `vre` of binary operation
+ *  @details See tcp::binop_split and tcp::parse_binop for the layouts
+ *  @tparam NARROW - whether `iter` is a narrow bycode (see tbycode)
+ *  @param top - the free slot above the first element of vmstack
+ *  @return the free slot above the first element after the operation
+ */
+template<bool NARROW = false>
+tobj * binop_locate(tbycode * iter, tcompo_env * const env, tobj * top,
+			tobj *& v1, tobj *& v2, tobj *& vre)
+{
+	uint16_t left = NARROW ? iter->get_Lk_n() : iter->get_Lk();
+	uint16_t right = NARROW ? iter->get_Rk_n() : iter->get_Rk();
+
+	switch (iter->get_k()) {
+	case BINOP_VV:
+		v1 = top - 1 - left;
+		v2 = vre = top - 1 - right;
+		return top - 1;
+	case BINOP_EV:
+		v1 = &locate_obj_lrk(left, env);
+		v2 = vre = top - 1 - right;
+		return top;
+	case BINOP_VE:
+		v1 = vre = top - 1 - left;
+		v2 = &locate_obj_lrk(right, env);
+		return top;
+	case BINOP_EE:
+		v1 = &locate_obj_lrk(left, env);
+		v2 = &locate_obj_lrk(right, env);
+		vre = top;
+		vre->set_nil();  // may hold a popped value
+		return top + 1;
+	case BINOP_TV:
+		v1 = &get_obj(left);
+		v2 = vre = top - 1 - right;
+		return top;
+	case BINOP_VT:
+		v1 = vre = top - 1 - left;
+		v2 = &get_obj(right);
+		return top;
+	case BINOP_TT:
+		v1 = &get_obj(left);
+		v2 = &get_obj(right);
+		vre = top;
+		vre->set_nil();  // may hold a popped value
+		return top + 1;
+	case BINOP_ET:
+		v1 = &locate_obj_lrk(left, env);
+		v2 = &get_obj(right);
+		vre = top;
+		vre->set_nil();  // may hold a popped value
+		return top + 1;
+	case BINOP_TE:
+		v1 = &get_obj(left);
+		v2 = &locate_obj_lrk(right, env);
+		vre = top;
+		vre->set_nil();  // may hold a popped value
+		return top + 1;
+	}
+	v1 = v2 = vre = nullptr;
+	twarn(ErrRuntime_Other).warn("tvm::binop_locate", "invalid operands layout");
+	return top;
+}
+
+/** OP_ADD : OP_OR
+ *  @tparam NARROW - whether `iter` is a narrow bycode (a fused comparison)
+ *  @param top - the free slot above the first element of vmstack
+ *  @return the free slot above the first element after the operation
+ */
+template<bool NARROW = false>
+tobj * parse_binop(const binopf & f, tbycode * iter, tcompo_env * const env, tobj * top)
+{
+	tobj * v1, * v2, * vre;
+	tobj * rtop = binop_locate<NARROW>(iter, env, top, v1, v2, vre);
+
+	f(*v1, *v2, *vre);
+	if (rtop < top)
+		rtop->try_clear(); // the popped operand (value value)
+	return rtop;
+}
+
+/// Get the value of `v` to `x` if `v` is an integer
+static bool num_of(const tobj & v, long & x)
+{
+	if (v.get_type() != tint)
+		return false;
+	x = v.get_v_tint();
+	return true;
+}
+
+/// Get the value of `v` to `x` if `v` is a double float
+static bool num_of(const tobj & v, double & x)
+{
+	if (v.get_type() != tdouble)
+		return false;
+	x = v.get_v_tdouble();
+	return true;
+}
+
+/** Rewrite the generic binary operation `iter` to `ins_ii` (`ins_dd`) if
+ *  both of its operands are integers (double floats), and fit the narrow
+ *  bycode (see tbycode::set_ins)
+ */
+void quicken_binop(tbycode * iter, tcompo_env * const env, tobj * top,
+			tins ins_ii, tins ins_dd)
+{
+	tobj * v1, * v2, * vre;
+	binop_locate(iter, env, top, v1, v2, vre);
+	ttypes type_v1 = v1->get_type();
+
+	if (type_v1 == v2->get_type()) {
+		if (type_v1 == tint)
+			iter->set_ins(ins_ii);
+		else if (type_v1 == tdouble)
+			iter->set_ins(ins_dd);
 	}
 }
 
-/// Execute a single Instruction
-void exec_tin(tbycode *& iter, uint_size_cmd & idx, uint_size_cmd end, tcompo_env * env,
-		long * cintlsts, double * cdbllsts, char ** cstrlsts)
+/** OP_ADD_II : OP_SL_DD, quickened binary operations on two numbers of type T
+ *  @details `f` is called directly on the numbers, skipping the type
+ *  dispatching of the generic operators.
+ *  @param top - the free slot above the first element of vmstack, updated
+ *               only if the operation is done
+ *  @return false if the operands are not both of type T (nothing is done)
+ */
+template<typename T, typename F>
+bool parse_binop_quick(F f, tbycode * iter, tcompo_env * const env, tobj *& top)
 {
-	// printf("%s\n", iter->tostring().c_str());
+	tobj * v1, * v2, * vre;
+	tobj * rtop = binop_locate<true>(iter, env, top, v1, v2, vre);
+	T x1, x2;
 
-	switch (iter->ins()) {
-	case OP_PASS: {
-		break;
+	if (!num_of(*v1, x1) || !num_of(*v2, x2))
+		return false;
+	vre->set_v(f(x1, x2)); // vre is either a number or a free slot
+	top = rtop;
+	return true;
+}
+
+/** OP_EQJPF : OP_SLJPF, comparison fused with the OP_CJPFPOP after it
+ *  @details On two integers or two double floats, the comparison is done
+ *  by `fi` or `fd` and `iter` is moved to OP_CJPFPOP (plus its jump if the
+ *  comparison is false).
+ *  @return false if the operands are of other types (nothing is done)
+ */
+bool parse_cmpjpf(bool (*fi)(const long &, const long &),
+			bool (*fd)(const double &, const double &),
+			tbycode *& iter, tcompo_env * const env, tobj *& top)
+{
+	tobj * v1, * v2, * vre;
+	tobj * rtop = binop_locate<true>(iter, env, top, v1, v2, vre);
+	ttypes type = v1->get_type();
+	bool re = false;
+
+	if (type != v2->get_type())
+		return false;
+	if (type == tint)
+		re = fi(v1->get_v_tint(), v2->get_v_tint());
+	else if (type == tdouble)
+		re = fd(v1->get_v_tdouble(), v2->get_v_tdouble());
+	else
+		return false;
+	top = rtop - 1; // the result is popped by OP_CJPFPOP
+	++iter;
+	if (!re)
+		iter += iter->get_U();
+	return true;
+}
+
+/** OP_INCR : OP_SUBXC, get the variable of the fused OP_ADD / OP_SUB
+ *  @details See tanalyser::fuse_superins for the fused sequences
+ */
+tobj & superins_var(tbycode * iter, tcompo_env * const env)
+{
+	tbycode * op = iter + 1;
+	return op->get_k() == BINOP_EV ? locate_obj_lrk(op->get_Lk(), env) : get_obj(op->get_Lk());
+}
+
+/// Register the built-in composite types to the operator tables (see tcompo_ops),
+/// once for all the virtual machines: a local static is initialized once,
+/// other threads waiting for it
+static void register_compo_types()
+{
+	struct tregistry
+	{
+		tregistry()
+		{
+			tcompo_register<tpair>(compo_tpair);
+			tcompo_register<tstr>(compo_tstr);
+			tcompo_register<tdict>(compo_tdict);
+			tcompo_register<tlist>(compo_tlist);
+			tcompo_register<ttime>(compo_time);
+			tcompo_register<titer>(compo_titer);
+			tcompo_register<tfunc>(compo_tfunc);
+			tcompo_register<tcppgenf>(compo_cppfunc);
+			tcompo_register<tcppsessf>(compo_sessfunc);
+			tcompo_register<tdarr>(compo_tdarr);
+			tcompo_register<tbarr>(compo_tbarr);
+			tcompo_register<tlib>(compo_tlib);
+			tcompo_register<trecord>(compo_trecord);
+		}
+	};
+	static const tregistry registry;
+}
+
+/// Get wrapper from the top father environment of env
+twrapper * get_wrapper_from_env(tcompo_env_abstract * env)
+{
+	while (env->get_father_env())
+		env = env->get_father_env();
+
+	tlib * lib_env = static_cast<tlib *>(env);
+	return lib_env->get_wrapper();
+}
+
+public:
+
+/** Constructor of tvm class
+ *  @param tmpmax - the maximum length of temporary objects to be decleared
+ */
+tvm(uint_size_obj tmpmax = 0)
+{
+	__gc = tgc::get_current();
+	__gc->add_holder(this);
+	__vstk = new tobj[VMSTACK_SIZE_LIMIT];
+	__tmps = __vstk;
+	__ntmps = 0;
+	__tmpmax = 0;
+	__stk = __vstk;
+	__stklen = 0;
+	set_tmpmax(tmpmax);
+	register_compo_types();
+}
+
+/// Deconstructor
+~tvm()
+{
+	clean();
+	del_obj(__ntmps);
+	delete [] __vstk;
+	__gc->rm_holder(this);
+	__gc->release();
+}
+
+/// Visit the values in the temporary objects and the registers of the
+/// frames, and __rev (see tgc)
+void gc_held(tgc_visitf f, void * arg)
+{
+	for (auto iter = __frames.begin(); iter != __frames.end(); iter++) {
+		for (tobj * v = iter->tmps; v < iter->tmps + iter->ntmps; v++)
+			tgc::visit(*v, f, arg);
+		for (tobj * v = iter->stk; v < iter->top; v++)
+			tgc::visit(*v, f, arg);
 	}
-	case OP_VCRT: {
+	for (tobj * v = __tmps; v < __tmps + __ntmps; v++)
+		tgc::visit(*v, f, arg);
+	for (tobj * v = __stk; v < __stk + __stklen; v++)
+		tgc::visit(*v, f, arg);
+	tgc::visit(__rev, f, arg);
+}
+
+/// Clean virtual machine
+void clean()
+{
+	__rev.try_clear();
+	vmstk_pop_clean_front_n(__stklen);
+}
+
+/// Set the maximum room for temporary variables of the bottom frame.
+/// Old values of temporary variables are kept.
+void set_tmpmax(uint_size_obj tmpmax)
+{
+	// registers popped without cleaning may be left there
+	for (; __tmpmax < tmpmax; __tmpmax++)
+		__vstk[__tmpmax].set_nil();
+}
+
+/// The reference of __rev
+inline tobj & get_vre()
+{
+	return __rev;
+}
+
+/** Excute bycodes from `from` to the `from _ ncmds`
+ *  @details Bycodes are dispatched by direct threading through a table of
+ *  label addresses indexed by the code of bycodes if `Tap_THREADED_DISPATCH` is
+ *  defined, otherwise by a portable `switch` loop. The constant pools and
+ *  the top of vmstack are kept in locals; `__stklen` is synchronized
+ *  around the helpers working on vmstack. Tapas functions are called by
+ *  OP_EVALTF on a new frame in the same loop, and return to their caller
+ *  at the end of their bycodes.
+ *  @param from  - Starting point of bycodes
+ *  @param ncmds - Number of bycodes to be executed
+ *  @param env   - Current running environment
+ */
+void exec_tins(uint_size_cmd from, uint_size_cmd ncmds, tcompo_env * env)
+{
+	const twrapper * wrapper = get_wrapper_from_env(env);
+	long * cintlsts = wrapper->consts.cints;
+	double * cdbllsts = wrapper->consts.cdbls;
+	char ** cstrlsts = wrapper->consts.cstrs;
+	tproto ** protolsts = wrapper->protos;
+	tbycode * cmdarr = wrapper->cmdarr;
+	tbycode * iter = cmdarr + from;
+	tbycode * end = iter + ncmds;
+	tobj * top = __stk + __stklen;
+	const size_t depth = __frames.size();
+
+#define Tap_STK_SAVE() (__stklen = static_cast<uint_size_stk>(top - __stk))
+#define Tap_STK_LOAD() (top = __stk + __stklen)
+#define Tap_GC_POINT() { if (__gc->is_due()) { Tap_STK_SAVE(); __gc->collect_due(); } }
+#define Tap_LOAD_WRAPPER(w) { \
+	wrapper = (w); \
+	cintlsts = wrapper->consts.cints; \
+	cdbllsts = wrapper->consts.cdbls; \
+	cstrlsts = wrapper->consts.cstrs; \
+	protolsts = wrapper->protos; \
+	cmdarr = wrapper->cmdarr; }
+#define Tap_JUMP_TFUNC(f) { \
+	const twrapper * fwrapper = static_cast<tlib *>((f)->get_lib())->get_wrapper(); \
+	if (fwrapper != wrapper) \
+		Tap_LOAD_WRAPPER(fwrapper); \
+	iter = cmdarr + (f)->get_cmdloc() - 1; \
+	end = iter + 1 + (f)->get_ncmds(); \
+	Tap_NEXT(); }
+
+#ifdef Tap_THREADED_DISPATCH
+	/* Must be in the same order as `tapas::tins` */
+	static void * const labels[] = {
+		&&L_OP_PASS,    &&L_OP_VCRT,    &&L_OP_TMPDEL,  &&L_OP_THIS,
+		&&L_OP_BASE,    &&L_OP_RET,     &&L_OP_IN,      &&L_OP_PAIR,
+		&&L_OP_TO,      &&L_OP_POPN,    &&L_OP_POPCOV,  &&L_OP_LOOPAS,
+		&&L_OP_LOOPIAS, &&L_OP_LOOPLAS, &&L_OP_LOOPGAS, &&L_OP_JPF,
+		&&L_OP_JPB,     &&L_OP_CJPFPOP, &&L_OP_CJPBPOP, &&L_OP_PUSHX,
+		&&L_OP_PUSHI,   &&L_OP_PUSHD,   &&L_OP_PUSHB,   &&L_OP_PUSHS,
+		&&L_OP_PUSHDICT,&&L_OP_PUSHINFO,&&L_OP_IMPORT,  &&L_OP_IDXR,
+		&&L_OP_EVAL,    &&L_OP_EVALSF,  &&L_OP_EVALCF,  &&L_OP_EVALTF,
+		&&L_OP_IDXL,    &&L_OP_PUSHF,   &&L_OP_ADD,     &&L_OP_SUB,
+		&&L_OP_MUL,     &&L_OP_DIV,     &&L_OP_MOD,     &&L_OP_POW,
+		&&L_OP_MMUL,    &&L_OP_EQ,      &&L_OP_NE,      &&L_OP_GE,
+		&&L_OP_SG,      &&L_OP_LE,      &&L_OP_SL,      &&L_OP_AND,
+		&&L_OP_OR,      &&L_OP_TEVAL,   &&L_OP_PUSHREC, &&L_OP_FORPREP,
+		&&L_OP_FORLOOP, &&L_OP_BREAK,   &&L_OP_CONTI,
+		&&L_OP_ADD_II,  &&L_OP_SUB_II,  &&L_OP_MUL_II,  &&L_OP_DIV_II,
+		&&L_OP_MOD_II,  &&L_OP_POW_II,  &&L_OP_EQ_II,   &&L_OP_NE_II,
+		&&L_OP_GE_II,   &&L_OP_SG_II,   &&L_OP_LE_II,   &&L_OP_SL_II,
+		&&L_OP_ADD_DD,  &&L_OP_SUB_DD,  &&L_OP_MUL_DD,  &&L_OP_DIV_DD,
+		&&L_OP_MOD_DD,  &&L_OP_POW_DD,  &&L_OP_EQ_DD,   &&L_OP_NE_DD,
+		&&L_OP_GE_DD,   &&L_OP_SG_DD,   &&L_OP_LE_DD,   &&L_OP_SL_DD,
+		&&L_OP_INCR,    &&L_OP_DECR,    &&L_OP_ADDXC,   &&L_OP_SUBXC,
+		&&L_OP_EQJPF,   &&L_OP_NEJPF,   &&L_OP_GEJPF,   &&L_OP_SGJPF,
+		&&L_OP_LEJPF,   &&L_OP_SLJPF,   &&L_OP_PUSHP,   &&L_OP_PUSHK,
+		&&L_OP_IDXLK,   &&L_OP_PUSHRECS,&&L_OP_PUSHSC
+	};
+	static_assert(sizeof(labels) / sizeof(labels[0]) == OP_NINS, "labels of all bycodes");
+
+	/* Indexed by the lower 8 bits of bycodes (see tbycode::ins_of), made once */
+	struct tdispatch
+	{
+		void * table[256];
+
+		tdispatch(void * const * labels)
+		{
+			for (unsigned code = 0; code < 256; code++) {
+				tins ins = tbycode::ins_of(static_cast<uint8_t>(code));
+				table[code] = labels[ins < OP_NINS ? ins : OP_PASS];
+			}
+		}
+	};
+	static const tdispatch dispatch(labels);
+	void * const * dispatch_table = dispatch.table;
+#define Tap_CASE(op) L_##op
+#define Tap_NEXT()   { if (++iter < end) goto *dispatch_table[iter->code()]; goto exec_end; }
+#else
+#define Tap_CASE(op) case op
+#define Tap_NEXT()   { ++iter; goto exec_loop; }
+#endif
+
+#define Tap_BINOP(f) { \
+	top = parse_binop(f, iter, env, top); \
+	Tap_NEXT(); }
+
+	/* Generic binary operations quicken themselves on numbers */
+#define Tap_BINOP_Q(f, op_ii, op_dd) { \
+	tbycode generic = *iter; \
+	quicken_binop(iter, env, top, op_ii, op_dd); \
+	top = parse_binop(f, &generic, env, top); \
+	Tap_NEXT(); }
+
+	/* Fused comparisons fall back to the generic ones on a miss */
+#define Tap_CMPJPF(w, f) { \
+	if (!parse_cmpjpf(&w<bool, long, long>, &w<bool, double, double>, iter, env, top)) \
+		top = parse_binop<true>(f, iter, env, top); \
+	Tap_NEXT(); }
+
+	/* Quickened binary operations fall back to the generic ones on a miss */
+#define Tap_BINOP_QUICK(quick, op, f) { \
+	if (!(quick)) { \
+		iter->set_ins(op); \
+		top = parse_binop(f, iter, env, top); \
+	} \
+	Tap_NEXT(); }
+
+	try {
+#ifdef Tap_THREADED_DISPATCH
+	if (iter >= end)
+		goto exec_end;
+	goto *dispatch_table[iter->code()];
+#else
+exec_loop:
+	if (iter >= end)
+		goto exec_end;
+	switch (iter->ins())
+#endif
+	{
+	Tap_CASE(OP_PASS): {
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_VCRT): {
 		uint_size_cst nameloc = iter->get_C();
 		bool isenv = iter->get_P();
 
 		if (isenv)
 			env->add_obj(nameloc);
 		else
-			add_obj(nameloc);
-		break;
+			add_obj();
+		Tap_NEXT();
 	}
-	case OP_TMPDEL: {
+	Tap_CASE(OP_TMPDEL): {
 		del_obj(iter->get_U());
-		break;
-	}
-	case OP_THIS: {
-		copy_env(env, topfree_rv());
-		topfree_filled();
-		break;
-	}
-	case OP_BASE: {
-		copy_env(env->get_father_env(), topfree_rv());
-		topfree_filled();
-		break;
+		Tap_NEXT();
 	}
-	case OP_BREAK: {
-		while (iter->ins() != OP_JPB && idx < end) {
-			idx++;
-			iter++;
-		}
-		break;
-	}
-	case OP_CONTI: {
-		while (iter->ins() != OP_JPB && idx < end) {
-			idx++;
-			iter++;
-		}
-		if (iter->ins() == OP_JPB) {
-			idx--;
-			iter--;
-		}
-		break;
-	}
-	case OP_RET: {
-		if (vmstk_size() > 0) {
-			__rev = vmstk_top();
-			vmstk_pop_front();
-
-			/* Check reference variables returned to be freed in recursion. */
-			if (__rev.get_type() == tcompo && env->tenv_get_compo_type() == compo_tfunc) {
-				tfunc * f = static_cast<tfunc *>(env);
-				uint_size_obj loc = env->get_ref_obj_loc(__rev.get_v_tcompo());
-
-				if (__rev.get_v_tcompo()->get_refctr() > 0 // __rev seems normal
-				&& f->get_refctr() == 0            // but f is to be freed, and
-				&& loc < env->get_objlst_len()     // __rev refers a local var
-				&& loc >= f->get_nparams())        // which is not a parameter.
-					twarn(ErrRuntime_RecurseRefRet).warn("tvm::exec_tins", "");
-			}
-		} else
+	Tap_CASE(OP_THIS): {
+		if (env->tenv_get_compo_type() == compo_tfunc)
+			top->set_v(static_cast<tfunc *>(env)); // re-entrant, no copy
+		else
+			copy_env(env, *top);
+		++top;
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_BASE): {
+		copy_env(env->get_father_env(), *top);
+		++top;
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_BREAK):
+	Tap_CASE(OP_CONTI): {
+		/* resolved to OP_JPF/OP_JPB by the compiler */
+		twarn(ErrRuntime_Other).warn("tvm::exec_tins", "unresolved break/continue");
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_RET): {
+		if (top > __stk)
+			__rev = *(--top);
+		else
 			set_rev_empty();
 
-		vmstk_pop_clean_front_n(vmstk_size());
-		idx = end;
-		return;
+		while (top > __stk)
+			(--top)->try_clear();
+		goto exec_end;
 	}
-	case OP_IN: {
-		operator_in(vmstk_top(), vmstk_at(1), __rev);
-		vmstk_pop_clean_front_n(2);
-		vmstk_push_front_v(__rev);
+	Tap_CASE(OP_IN): {
+		operator_in(top[-1], top[-2], __rev);
+		(--top)->try_clear();
+		(--top)->try_clear();
+		*(top++) = __rev;
 		set_rev_empty();
-		break;
+		Tap_NEXT();
 	}
-	case OP_PAIR: {
-		operator_pair(vmstk_top(), vmstk_at(1), __rev);
-		vmstk_pop_clean_front_n(2);
-		vmstk_push_front_v(__rev);
+	Tap_CASE(OP_PAIR): {
+		operator_pair(top[-1], top[-2], __rev);
+		(--top)->try_clear();
+		(--top)->try_clear();
+		*(top++) = __rev;
 		set_rev_empty();
-		break;
+		Tap_NEXT();
 	}
-	case OP_TO: {
-		operator_to(vmstk_top(), vmstk_at(1), __rev);
-		vmstk_pop_clean_front_n(2);
-		vmstk_push_front_v(__rev);
+	Tap_CASE(OP_TO): {
+		operator_to(top[-1], top[-2], __rev);
+		(--top)->try_clear();
+		(--top)->try_clear();
+		*(top++) = __rev;
 		set_rev_empty();
-		break;
+		Tap_NEXT();
 	}
-	case OP_POPN: {
+	Tap_CASE(OP_POPN): {
 		bool print = iter->get_R();
 
 		for (uint_size_stk i = 0; i < static_cast<uint_size_stk>(iter->get_L()); i++) {
-			if (print && vmstk_top().get_type() != tnil)
-				printf("%s\n", vmstk_top().tostring_full().c_str());
-			vmstk_pop_clean_front();
+			if (print && top[-1].get_type() != tnil)
+				printf("%s\n", top[-1].tostring_full().c_str());
+			(--top)->try_clear();
 		}
-		break;
+		Tap_NEXT();
 	}
-	case OP_POPCOV: {
+	Tap_CASE(OP_POPCOV): {
 		if (iter->get_R())
-			env->set_obj(iter->get_L(), vmstk_top());
+			env->set_obj_at(iter->get_R() - 1, iter->get_L(), top[-1]);
 		else
-			set_obj(iter->get_L(), vmstk_top());
-		vmstk_pop_front();
-		break;
-	}
-	case OP_LOOPAS: {
-		parse_loopas(iter, topfree_rv(), env);
-		topfree_filled();
-		break;
-	}
-	case OP_LOOPIAS: {
-		titer * p = reinterpret_cast<titer *>(vmstk_top().get_v_tcompo());
-		topfree_rv().set_v(p->next());
-		uint_size_cmd vloc = iter->get_L();
-		bool isenv = iter->get_R();
-		if (isenv)
-			env->get_obj(vloc).set_v(p->get_locidx());
+			set_obj(iter->get_L(), top[-1]);
+		--top;
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_LOOPAS): {
+		Tap_STK_SAVE();
+		parse_loopas(iter, *top, env);
+		++top;
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_LOOPIAS): {
+		titer * p = reinterpret_cast<titer *>(top[-1].get_v_tcompo());
+		top->set_v(p->next());
+		locate_obj(iter->get_L(), iter->get_R(), env).set_v(p->get_locidx());
+		++top;
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_FORPREP): { // end, start: the counter and the bound of OP_FORLOOP
+		if (top[-1].get_type() != tint || top[-2].get_type() != tint)
+			twarn(ErrRuntime_ParamsType).warn("operator_to", "");
+		top[-1].set_v(top[-1].get_v_tint() - 1);
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_FORLOOP): { // as OP_LOOPIAS on `start to end`
+		long i = top[-1].get_v_tint() + 1;
+		top[-1].set_v(i);
+		top->set_v(i < top[-2].get_v_tint());
+		tobj & o = locate_obj(iter->get_L(), iter->get_R(), env);
+
+		if (o.get_type() == tint)
+			o.set_v(i);
+		else if (iter->get_R())
+			env->set_obj_at(iter->get_R() - 1, iter->get_L(), tobj(i));
 		else
-			get_obj(vloc).set_v(p->get_locidx());
-		topfree_filled();
-		break;
-	}
-	case OP_LOOPLAS: {
-		tlist * p = reinterpret_cast<tlist *>(vmstk_top().get_v_tcompo());
-		parse_loopas_basic(p, iter->get_L(), topfree_rv(), iter->get_R(), env);
-		topfree_filled();
-		break;
-	}
-	case OP_LOOPGAS: {
-		const tobj & v_iter = vmstk_top();
-		tcompo_v * it = v_iter.get_v_tcompo();
-		tcompo_iter * ptype = dynamic_cast<tcompo_iter *>(it);
-		parse_loopas_basic(ptype, iter->get_L(), topfree_rv(), iter->get_R(), env);
-		topfree_filled();
-		break;
-	}
-	case OP_JPF: {
-		idx += iter->get_U();
+			set_obj(iter->get_L(), tobj(i));
+		++top;
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_LOOPLAS): {
+		tlist * p = reinterpret_cast<tlist *>(top[-1].get_v_tcompo());
+		parse_loopas_basic(p, iter->get_L(), *top, iter->get_R(), env);
+		++top;
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_LOOPGAS): {
+		tcompo_v * it = top[-1].get_v_tcompo();
+		tcompo_iter * ptype = tcompo_ops<tcompo_iter>::cast(it);
+		parse_loopas_basic(ptype, iter->get_L(), *top, iter->get_R(), env);
+		++top;
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_JPF): {
 		iter += iter->get_U();
-		break;
+		Tap_NEXT();
 	}
-	case OP_JPB: {
-		idx -= iter->get_U();
+	Tap_CASE(OP_JPB): {
 		iter -= iter->get_U();
-		break;
+		Tap_GC_POINT();
+		Tap_NEXT();
 	}
-	case OP_CJPFPOP: {
-		if (vmstk_top().get_type() == tbool && vmstk_top().get_v_tbool() == 0) {
-			uint_size_cmd U = iter->get_U();
-			idx += U;
-			iter += U;
-			vmstk_pop_front();
+	Tap_CASE(OP_CJPFPOP): {
+		if (top[-1].get_type() == tbool && top[-1].get_v_tbool() == 0) {
+			iter += iter->get_U();
+			--top;
 		}
 		else
-			vmstk_pop_clean_front();
-		break;
-	}
-	case OP_CJPBPOP: {
-		if (vmstk_top().get_type() == tbool && vmstk_top().get_v_tbool() == 0) {
-			uint_size_cmd U = iter->get_U();
-			idx -= U;
-			iter -= U;
-			vmstk_pop_front();
+			(--top)->try_clear();
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_CJPBPOP): {
+		if (top[-1].get_type() == tbool && top[-1].get_v_tbool() == 0) {
+			iter -= iter->get_U();
+			--top;
+			Tap_GC_POINT();
 		}
 		else
-			vmstk_pop_clean_front();
-		break;
-	}
-	case OP_PUSHX: {
-		uint_size_obj loc = iter->get_L();
-		bool isenv = iter->get_R();
-		if (isenv)
-			topfree_rv() = env->get_obj(loc);
+			(--top)->try_clear();
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_PUSHX): {
+		*top = locate_obj(iter->get_L(), iter->get_R(), env);
+		++top;
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_PUSHI): {
+		(top++)->set_v(cintlsts[iter->get_U()]);
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_PUSHD): {
+		(top++)->set_v(cdbllsts[iter->get_U()]);
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_PUSHB): {
+		(top++)->set_v(bool(iter->get_U()));
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_PUSHS): {
+		(top++)->set_v(new tstr(cstrlsts[iter->get_U()]));
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_PUSHSC): {
+		(top++)->set_v(static_cast<tlib *>(env->get_top_env())->get_cstr(iter->get_U_n()));
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_PUSHK): {
+		tkeycache & cache = static_cast<tlib *>(env->get_top_env())->get_keycache(iter->get_U_n());
+		bool keyed;
+		tobj * v = find_keyed(locate_obj(iter[1].get_L(), iter[1].get_R(), env), true,
+				cache, cstrlsts[cache.name], keyed);
+
+		if (!keyed) { // OP_PUSHS, then OP_PUSHX, OP_IDXR as usual
+			(top++)->set_v(static_cast<tlib *>(env->get_top_env())->get_cstr(cache.name));
+			Tap_NEXT();
+		}
+		if (v != nullptr)
+			*top = *v;
 		else
-			topfree_rv() = get_obj(loc);
-		topfree_filled();
-		break;
-	}
-	case OP_PUSHI: {
-		topfree_rv().set_v(cintlsts[iter->get_U()]);
-		topfree_filled();
-		break;
-	}
-	case OP_PUSHD: {
-		topfree_rv().set_v(cdbllsts[iter->get_U()]);
-		topfree_filled();
-		break;
+			top->set_nil();
+		++top;
+		iter += 2; // OP_PUSHX, OP_IDXR
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_IDXLK): {
+		tkeycache & cache = static_cast<tlib *>(env->get_top_env())->get_keycache(iter->get_U_n());
+		bool keyed;
+		tobj * v = find_keyed(locate_obj(iter[1].get_L(), iter[1].get_i(), env), false,
+				cache, cstrlsts[cache.name], keyed);
+
+		if (v == nullptr) { // OP_PUSHS, then OP_IDXL as usual (e.g. adding the key)
+			(top++)->set_v(static_cast<tlib *>(env->get_top_env())->get_cstr(cache.name));
+			Tap_NEXT();
+		}
+		tdict::set_value(*v, top[-1]);
+		(--top)->try_clear();
+		++iter; // OP_IDXL
+		Tap_NEXT();
 	}
-	case OP_PUSHB: {
-		topfree_rv().set_v(bool(iter->get_U()));
-		topfree_filled();
-		break;
+	Tap_CASE(OP_PUSHREC): { // not bound at loading: a dict of the keys that follow
+		tdict * dict = new tdict();
+		uint_size_stk nparams = static_cast<uint_size_stk>(iter->get_U());
+		tobj * params = top - nparams;
+
+		for (uint_size_stk i = 0; i < nparams; i++)
+			dict->set(cstrlsts[iter[i + 1].get_U()], params[i]);
+		__rev.set_v(dict);
+		for (uint_size_stk i = 0; i < nparams; i++)
+			(--top)->try_clear();
+		*(top++) = __rev;
+		set_rev_empty();
+		iter += nparams;
+		Tap_NEXT();
 	}
-	case OP_PUSHS: {
-		topfree_rv().set_v(new tstr(cstrlsts[iter->get_U()]));
-		topfree_filled();
-		break;
+	Tap_CASE(OP_PUSHRECS): {
+		tshape * shape = static_cast<tlib *>(env->get_top_env())->get_shape(iter->get_U_n());
+		uint_size_stk nparams = static_cast<uint_size_stk>(shape->size());
+
+		__rev.set_v(new trecord(shape, top - nparams));
+		for (uint_size_stk i = 0; i < nparams; i++)
+			(--top)->try_clear();
+		*(top++) = __rev;
+		set_rev_empty();
+		iter += nparams; // OP_PUSHS of the keys
+		Tap_NEXT();
 	}
-	case OP_PUSHDICT: {
+	Tap_CASE(OP_PUSHDICT): {
 		tdict * dict = new tdict();
 		uint_size_stk nparams = static_cast<uint_size_stk>(iter->get_U());
-		tobj * params = vmstk_get_top_n(nparams);
+		tobj * params = top - nparams;
 
 		for (uint_size_stk i = 0; i < nparams; i++) {
 			dict->set_append(params);
 			params++;
 		}
 		__rev.set_v(dict);
-		vmstk_pop_clean_front_n(nparams);
-		vmstk_push_front_v(__rev);
+		for (uint_size_stk i = 0; i < nparams; i++)
+			(--top)->try_clear();
+		*(top++) = __rev;
 		set_rev_empty();
-		break;
+		Tap_NEXT();
 	}
-	case OP_PUSHINFO: {
-		topfree_rv().set_v(static_cast<long>(iter->get_U()));
-		topfree_filled();
-		break;
+	Tap_CASE(OP_PUSHINFO): {
+		(top++)->set_v(static_cast<long>(iter->get_U()));
+		Tap_NEXT();
 	}
-	case OP_IMPORT: {
+	Tap_CASE(OP_IMPORT): {
+		Tap_STK_SAVE();
 		parse_import(static_cast<uint_size_cst>(iter->get_U()), cstrlsts, env);
-		break;
+		Tap_STK_LOAD();
+		Tap_NEXT();
 	}
-	case OP_IDXR: {
+	Tap_CASE(OP_IDXR): {
+		Tap_STK_SAVE();
 		parse_idx(static_cast<uint_size_stk>(iter->get_U()));
-		break;
-	}
-	case OP_EVAL: {
+		Tap_STK_LOAD();
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_EVAL):
+	exec_eval: {
+		if (top[-1].get_type() == tcompo
+		&& top[-1].get_v_tcompo()->get_compo_type_code() == compo_tfunc) {
+			iter->set_ins(OP_EVALTF); // runtime optimiztion of bycodes
+			goto exec_call;
+		}
+		Tap_STK_SAVE();
 		parse_eval(iter, env);
-		break;
-	}
-	case OP_EVALSF: {
+		Tap_STK_LOAD();
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_EVALSF): {
+		if (top[-1].get_type() != tcompo
+		|| top[-1].get_v_tcompo()->get_compo_type_code() != compo_sessfunc) {
+			iter->set_ins(OP_EVAL);
+			goto exec_eval;
+		}
 		uint_size_stk nparams = static_cast<uint_size_stk>(iter->get_U());
-		tcompo_v * v = vmstk_top().get_v_tcompo();
-		tobj * params = this->vmstk_get_top_n(nparams + 1);
+		tcompo_v * v = top[-1].get_v_tcompo();
+		tobj * params = top - (nparams + 1);
+		Tap_STK_SAVE();
 		reinterpret_cast<tcppsessf *>(v)->get_f()(params, nparams, __rev, env);
-		vmstk_pop_clean_front_n(1 + nparams);
-		vmstk_push_front_v(__rev);
+		for (uint_size_stk i = 0; i <= nparams; i++)
+			(--top)->try_clear();
+		*(top++) = __rev;
 		set_rev_empty();
-		break;
+		Tap_NEXT();
 	}
-	case OP_EVALCF: {
+	Tap_CASE(OP_EVALCF): {
+		if (top[-1].get_type() != tcompo
+		|| top[-1].get_v_tcompo()->get_compo_type_code() != compo_cppfunc) {
+			iter->set_ins(OP_EVAL);
+			goto exec_eval;
+		}
 		uint_size_stk nparams = static_cast<uint_size_stk>(iter->get_U());
-		tcompo_v * v = vmstk_top().get_v_tcompo();
-		tobj * params = this->vmstk_get_top_n(nparams + 1);
+		tcompo_v * v = top[-1].get_v_tcompo();
+		tobj * params = top - (nparams + 1);
 		reinterpret_cast<tcppgenf *>(v)->get_f()(params, nparams, __rev);
-		vmstk_pop_clean_front_n(1 + nparams);
-		vmstk_push_front_v(__rev);
+		for (uint_size_stk i = 0; i <= nparams; i++)
+			(--top)->try_clear();
+		*(top++) = __rev;
 		set_rev_empty();
-		break;
+		Tap_NEXT();
 	}
-	case OP_EVALTF: {
-		break;
-	}
-	case OP_IDXL: {
+	Tap_CASE(OP_EVALTF):
+		if (top[-1].get_type() != tcompo
+		|| top[-1].get_v_tcompo()->get_compo_type_code() != compo_tfunc) {
+			iter->set_ins(OP_EVAL);
+			goto exec_eval;
+		}
+	exec_call: {
+		Tap_GC_POINT();
+		tfunc * f = reinterpret_cast<tfunc *>(top[-1].get_v_tcompo());
+		uint_size_stk nparams = static_cast<uint_size_stk>(iter->get_U());
+
+		// check parameter number
+		if (f->get_nparams() != UNDEF_NPARAMS && nparams != f->get_nparams())
+			twarn(ErrRuntime_ParamsCtr).warn("tvm::exec_tins", "");
+		tobj * params = top - (nparams + 1);
+		f = enter_tfunc(f, {env, iter, end, wrapper, top, params, nullptr, nullptr, 0, nullptr, 0});
+		env = f;
+		top = __stk;
+		f->assign_params(params, nparams);
+		Tap_JUMP_TFUNC(f);
+	}
+	Tap_CASE(OP_TEVAL): {
+		if (top[-1].get_type() != tcompo
+		|| top[-1].get_v_tcompo()->get_compo_type_code() != compo_tfunc) {
+			Tap_STK_SAVE();
+			parse_eval(iter, env);
+			Tap_STK_LOAD();
+			iter->set_ins(OP_TEVAL); // keep the tail call of this site
+			Tap_NEXT();
+		}
+		if (__frames.size() == depth)
+			goto exec_call;  // not in a function: call it, then OP_RET
+
+		// replace the running activation by the one of `f` on the same frame
+		tfunc * f = reinterpret_cast<tfunc *>(top[-1].get_v_tcompo());
+
+		// `f` is defined in the running function, which may be freed when
+		// left: keep it as the environment of `f` by a call, then OP_RET.
+		// Likewise if `f` is the running function and functions created in
+		// it read its locals, which the activation replacing would overwrite
+		if (f->is_below(env) || (f == env && f->is_captured()))
+			goto exec_call;
+		uint_size_stk nparams = static_cast<uint_size_stk>(iter->get_U());
+
+		if (f->get_nparams() != UNDEF_NPARAMS && nparams != f->get_nparams())
+			twarn(ErrRuntime_ParamsCtr).warn("tvm::exec_tins", "");
+		tobj * params = top - (nparams + 1);
+
+		// parameters and callee may refer to the locals to be freed
+		for (tobj * v = params; v < top; v++)
+			if (v->get_type() == tcompo)
+				v->get_v_tcompo()->add_refctr();
+		tframe caller = leave_tfunc(static_cast<tfunc *>(env), params);
+
+		// move them over the ones of the returning call, above which `f` runs
+		while (caller.top > caller.args)
+			(--caller.top)->try_clear();
+		std::copy(params, top, caller.args);
+		params = caller.args;
+		caller.top = params + nparams + 1;
+		env = caller.env;
+		top = caller.top;
+		f = enter_tfunc(f, caller);
+		env = f;
+		top = __stk;
+		f->assign_params(params, nparams);
+		for (tobj * v = params; v < caller.top; v++)
+			if (v->get_type() == tcompo)
+				v->get_v_tcompo()->ddc_refctr();
+		Tap_JUMP_TFUNC(f);
+	}
+	Tap_CASE(OP_IDXL): {
 		uint_size_obj loc = iter->get_L();
 		uint_size_stk nparams = iter->get_b();
-		bool isenv = iter->get_i();
-		parse_idxl(loc, nparams, isenv, env);
-		break;
-	}
-	case OP_PUSHF: {
-		uint_size_cmd ncmds = iter->get_U();
-		uint_size_stk nparams = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		uint_size_stk fregmax = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		uint_size_obj ntmps = static_cast<uint_size_obj>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		uint_size_obj nobjs = static_cast<uint_size_obj>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		tfunc * f = new tfunc(nobjs, env, fregmax, ntmps, nparams, idx + 1, ncmds);
-		idx += ncmds;
-		iter += ncmds;
-		topfree_rv().set_v(f);
-		topfree_filled();
-		break;
-	}
-	case OP_ADD: {
-		uint_size_stk type = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		parse_binop(operator_add, iter, type, env);
-		break;
-	}
-	case OP_SUB: {
-		uint_size_stk type = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		parse_binop(operator_sub, iter, type, env);
-		break;
-	}
-	case OP_MUL: {
-		uint_size_stk type = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		parse_binop(operator_mul, iter, type, env);
-		break;
-	}
-	case OP_DIV: {
-		uint_size_stk type = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		parse_binop(operator_div, iter, type, env);
-		break;
-	}
-	case OP_MOD: {
-		uint_size_stk type = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		parse_binop(operator_mod, iter, type, env);
-		break;
-	}
-	case OP_POW: {
-		uint_size_stk type = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		parse_binop(operator_pow, iter, type, env);
-		break;
-	}
-	case OP_MMUL: {
-		uint_size_stk type = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		parse_binop(operator_mmul, iter, type, env);
-		break;
-	}
-	case OP_EQ: {
-		uint_size_stk type = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		parse_binop(operator_eq, iter, type, env);
-		break;
-	}
-	case OP_NE: {
-		uint_size_stk type = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		parse_binop(operator_ne, iter, type, env);
-		break;
-	}
-	case OP_GE: {
-		uint_size_stk type = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		parse_binop(operator_ge, iter, type, env);
-		break;
-	}
-	case OP_SG: {
-		uint_size_stk type = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		parse_binop(operator_sg, iter, type, env);
-		break;
-	}
-	case OP_LE: {
-		uint_size_stk type = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		parse_binop(operator_le, iter, type, env);
-		break;
-	}
-	case OP_SL: {
-		uint_size_stk type = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		parse_binop(operator_sl, iter, type, env);
-		break;
-	}
-	case OP_AND: {
-		uint_size_stk type = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		parse_binop(operator_and, iter, type, env);
-		break;
-	}
-	case OP_OR: {
-		uint_size_stk type = static_cast<uint_size_stk>(vmstk_top().get_v_tint());
-		vmstk_pop_front();
-		parse_binop(operator_or, iter, type, env);
-		break;
+		uint_size_obj ienv = iter->get_i();
+		Tap_STK_SAVE();
+		parse_idxl(loc, nparams, ienv, env);
+		Tap_STK_LOAD();
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_PUSHF): {
+		// skipped by its OP_PUSHP, made for each at loading (see make_protos)
+		Tap_STK_SAVE();
+		twarn(ErrRuntime_Other).warn("tvm::eval_bycodes", "OP_PUSHF without its prototype");
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_PUSHP): {
+		if (__frames.size() > depth && __frames.back().locals != nullptr)
+			env = own_activation(static_cast<tfunc *>(env)); // closure of a re-entered function
+		tproto * proto = protolsts[iter->get_U_n()];
+		(top++)->set_v(new tfunc(proto, env));
+		iter += 4 + proto->ncmds; // OP_PUSHINFO x 3, OP_PUSHF and the body
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_ADD):  Tap_BINOP_Q(operator_add, OP_ADD_II, OP_ADD_DD)
+	Tap_CASE(OP_SUB):  Tap_BINOP_Q(operator_sub, OP_SUB_II, OP_SUB_DD)
+	Tap_CASE(OP_MUL):  Tap_BINOP_Q(operator_mul, OP_MUL_II, OP_MUL_DD)
+	Tap_CASE(OP_DIV):  Tap_BINOP_Q(operator_div, OP_DIV_II, OP_DIV_DD)
+	Tap_CASE(OP_MOD):  Tap_BINOP_Q(operator_mod, OP_MOD_II, OP_MOD_DD)
+	Tap_CASE(OP_POW):  Tap_BINOP_Q(operator_pow, OP_POW_II, OP_POW_DD)
+	Tap_CASE(OP_MMUL): Tap_BINOP(operator_mmul)
+	Tap_CASE(OP_EQ):   Tap_BINOP_Q(operator_eq, OP_EQ_II, OP_EQ_DD)
+	Tap_CASE(OP_NE):   Tap_BINOP_Q(operator_ne, OP_NE_II, OP_NE_DD)
+	Tap_CASE(OP_GE):   Tap_BINOP_Q(operator_ge, OP_GE_II, OP_GE_DD)
+	Tap_CASE(OP_SG):   Tap_BINOP_Q(operator_sg, OP_SG_II, OP_SG_DD)
+	Tap_CASE(OP_LE):   Tap_BINOP_Q(operator_le, OP_LE_II, OP_LE_DD)
+	Tap_CASE(OP_SL):   Tap_BINOP_Q(operator_sl, OP_SL_II, OP_SL_DD)
+	Tap_CASE(OP_AND):  Tap_BINOP(operator_and)
+	Tap_CASE(OP_OR):   Tap_BINOP(operator_or)
+	Tap_CASE(OP_ADD_II): Tap_BINOP_QUICK(
+		parse_binop_quick<long>(&wrapper_add<long, long, long>, iter, env, top),
+		OP_ADD, operator_add)
+	Tap_CASE(OP_SUB_II): Tap_BINOP_QUICK(
+		parse_binop_quick<long>(&wrapper_sub<long, long, long>, iter, env, top),
+		OP_SUB, operator_sub)
+	Tap_CASE(OP_MUL_II): Tap_BINOP_QUICK(
+		parse_binop_quick<long>(&wrapper_mul<long, long, long>, iter, env, top),
+		OP_MUL, operator_mul)
+	Tap_CASE(OP_DIV_II): Tap_BINOP_QUICK(
+		parse_binop_quick<long>(&wrapper_div_int, iter, env, top),
+		OP_DIV, operator_div)
+	Tap_CASE(OP_MOD_II): Tap_BINOP_QUICK(
+		parse_binop_quick<long>(static_cast<double (*)(double, double)>(fmod), iter, env, top),
+		OP_MOD, operator_mod)
+	Tap_CASE(OP_POW_II): Tap_BINOP_QUICK(
+		parse_binop_quick<long>(static_cast<double (*)(double, double)>(pow), iter, env, top),
+		OP_POW, operator_pow)
+	Tap_CASE(OP_EQ_II): Tap_BINOP_QUICK(
+		parse_binop_quick<long>(&wrapper_eq<bool, long, long>, iter, env, top),
+		OP_EQ, operator_eq)
+	Tap_CASE(OP_NE_II): Tap_BINOP_QUICK(
+		parse_binop_quick<long>(&wrapper_ne<bool, long, long>, iter, env, top),
+		OP_NE, operator_ne)
+	Tap_CASE(OP_GE_II): Tap_BINOP_QUICK(
+		parse_binop_quick<long>(&wrapper_ge<bool, long, long>, iter, env, top),
+		OP_GE, operator_ge)
+	Tap_CASE(OP_SG_II): Tap_BINOP_QUICK(
+		parse_binop_quick<long>(&wrapper_sg<bool, long, long>, iter, env, top),
+		OP_SG, operator_sg)
+	Tap_CASE(OP_LE_II): Tap_BINOP_QUICK(
+		parse_binop_quick<long>(&wrapper_le<bool, long, long>, iter, env, top),
+		OP_LE, operator_le)
+	Tap_CASE(OP_SL_II): Tap_BINOP_QUICK(
+		parse_binop_quick<long>(&wrapper_sl<bool, long, long>, iter, env, top),
+		OP_SL, operator_sl)
+	Tap_CASE(OP_ADD_DD): Tap_BINOP_QUICK(
+		parse_binop_quick<double>(&wrapper_add<double, double, double>, iter, env, top),
+		OP_ADD, operator_add)
+	Tap_CASE(OP_SUB_DD): Tap_BINOP_QUICK(
+		parse_binop_quick<double>(&wrapper_sub<double, double, double>, iter, env, top),
+		OP_SUB, operator_sub)
+	Tap_CASE(OP_MUL_DD): Tap_BINOP_QUICK(
+		parse_binop_quick<double>(&wrapper_mul<double, double, double>, iter, env, top),
+		OP_MUL, operator_mul)
+	Tap_CASE(OP_DIV_DD): Tap_BINOP_QUICK(
+		parse_binop_quick<double>(&wrapper_div<double, double, double>, iter, env, top),
+		OP_DIV, operator_div)
+	Tap_CASE(OP_MOD_DD): Tap_BINOP_QUICK(
+		parse_binop_quick<double>(static_cast<double (*)(double, double)>(fmod), iter, env, top),
+		OP_MOD, operator_mod)
+	Tap_CASE(OP_POW_DD): Tap_BINOP_QUICK(
+		parse_binop_quick<double>(static_cast<double (*)(double, double)>(pow), iter, env, top),
+		OP_POW, operator_pow)
+	Tap_CASE(OP_EQ_DD): Tap_BINOP_QUICK(
+		parse_binop_quick<double>(&wrapper_eq<bool, double, double>, iter, env, top),
+		OP_EQ, operator_eq)
+	Tap_CASE(OP_NE_DD): Tap_BINOP_QUICK(
+		parse_binop_quick<double>(&wrapper_ne<bool, double, double>, iter, env, top),
+		OP_NE, operator_ne)
+	Tap_CASE(OP_GE_DD): Tap_BINOP_QUICK(
+		parse_binop_quick<double>(&wrapper_ge<bool, double, double>, iter, env, top),
+		OP_GE, operator_ge)
+	Tap_CASE(OP_SG_DD): Tap_BINOP_QUICK(
+		parse_binop_quick<double>(&wrapper_sg<bool, double, double>, iter, env, top),
+		OP_SG, operator_sg)
+	Tap_CASE(OP_LE_DD): Tap_BINOP_QUICK(
+		parse_binop_quick<double>(&wrapper_le<bool, double, double>, iter, env, top),
+		OP_LE, operator_le)
+	Tap_CASE(OP_SL_DD): Tap_BINOP_QUICK(
+		parse_binop_quick<double>(&wrapper_sl<bool, double, double>, iter, env, top),
+		OP_SL, operator_sl)
+	Tap_CASE(OP_INCR): {
+		tobj & x = superins_var(iter, env);
+		long c = cintlsts[iter->get_U_n()];
+
+		if (x.get_type() == tint) {
+			x.set_v(x.get_v_tint() + c);
+			iter += 2;
+		} else if (x.get_type() == tdouble) {
+			x.set_v(x.get_v_tdouble() + c);
+			iter += 2;
+		} else
+			(top++)->set_v(c); // OP_PUSHI
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_DECR): {
+		tobj & x = superins_var(iter, env);
+		long c = cintlsts[iter->get_U_n()];
+
+		if (x.get_type() == tint) {
+			x.set_v(x.get_v_tint() - c);
+			iter += 2;
+		} else if (x.get_type() == tdouble) {
+			x.set_v(x.get_v_tdouble() - c);
+			iter += 2;
+		} else
+			(top++)->set_v(c); // OP_PUSHI
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_ADDXC): {
+		const tobj & x = superins_var(iter, env);
+		long c = cintlsts[iter->get_U_n()];
+
+		if (x.get_type() == tint) {
+			(top++)->set_v(x.get_v_tint() + c);
+			iter += 1;
+		} else if (x.get_type() == tdouble) {
+			(top++)->set_v(x.get_v_tdouble() + c);
+			iter += 1;
+		} else
+			(top++)->set_v(c); // OP_PUSHI
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_SUBXC): {
+		const tobj & x = superins_var(iter, env);
+		long c = cintlsts[iter->get_U_n()];
+
+		if (x.get_type() == tint) {
+			(top++)->set_v(x.get_v_tint() - c);
+			iter += 1;
+		} else if (x.get_type() == tdouble) {
+			(top++)->set_v(x.get_v_tdouble() - c);
+			iter += 1;
+		} else
+			(top++)->set_v(c); // OP_PUSHI
+		Tap_NEXT();
+	}
+	Tap_CASE(OP_EQJPF): Tap_CMPJPF(wrapper_eq, operator_eq)
+	Tap_CASE(OP_NEJPF): Tap_CMPJPF(wrapper_ne, operator_ne)
+	Tap_CASE(OP_GEJPF): Tap_CMPJPF(wrapper_ge, operator_ge)
+	Tap_CASE(OP_SGJPF): Tap_CMPJPF(wrapper_sg, operator_sg)
+	Tap_CASE(OP_LEJPF): Tap_CMPJPF(wrapper_le, operator_le)
+	Tap_CASE(OP_SLJPF): Tap_CMPJPF(wrapper_sl, operator_sl)
+	}
+exec_end:
+	/* Return to the caller with __rev, like OP_EVAL */
+	if (__frames.size() > depth) {
+		// __rev may refer to the locals or the function to be freed
+		bool rev_compo = __rev.get_type() == tcompo;
+		if (rev_compo)
+			__rev.get_v_tcompo()->add_refctr();
+		tframe caller = leave_tfunc(static_cast<tfunc *>(env), top);
+
+		top = caller.top;
+		env = caller.env;
+		iter = caller.ret;
+		end = caller.end;
+		if (caller.wrapper != wrapper)
+			Tap_LOAD_WRAPPER(caller.wrapper);
+		while (top > caller.args)
+			(--top)->try_clear();
+		if (rev_compo)
+			__rev.get_v_tcompo()->ddc_refctr();
+		*(top++) = __rev;
+		set_rev_empty();
+		Tap_NEXT();
 	}
+	} catch (...) {
+		while (__frames.size() > depth) {
+			tframe caller = leave_tfunc(static_cast<tfunc *>(env), top);
+			top = caller.top;
+			env = caller.env;
+		}
+		Tap_STK_SAVE();
+		throw;
 	}
-}
-
-/// Get wrapper from the top father environment of env
-twrapper * get_wrapper_from_env(tcompo_env_abstract * env)
-{
-	while (env->get_father_env())
-		env = env->get_father_env();
-
-	tlib * lib_env = static_cast<tlib *>(env);
-	return lib_env->get_wrapper();
-}
-
-public:
-
-/** Constructor of tvm class
- *  @param tmpmax - the maximum length of temporary objects to be decleared
- */
-tvm(uint_size_obj tmpmax) : tobj_array(tmpmax)
-{
-	__stklen = 0;
-	__regmax = 0;
-	__stk = nullptr;
-	__inloop = 0;
-}
-
-/// Deconstructor
-~tvm()
-{
-	clean();
-}
-
-/// Clean virtual machine
-void clean()
-{
-	__rev.try_clear();
-	vmstk_pop_clean_front_n(__stklen);
-}
+	Tap_STK_SAVE();
 
-/// Set the maximum room for temporary variables
-void set_tmpmax(uint_size_obj tmpmax)
-{
-	try_expand_objlist(tmpmax);
-}
-
-/** Set __stk to be an outside Tapv array
- *  @param vmstack - (tapv *) A pointer to array of taps as vmstack
- *  @param nreg - (uint_regs) The maximum number of registers in vamstack
- */
-void set_vmstack(tobj * vmstack, uint_size_stk nreg)
-{
-	__stk = vmstack;
-	__regmax = nreg;
-	__stklen = 0;
-}
-
-/// The reference of __rev
-inline tobj & get_vre()
-{
-	return __rev;
-}
-
-/** Excute bycodes from `from` to the `from _ ncmds`
- *  @param from  - Starting point of bycodes
- *  @param ncmds - Number of bycodes to be executed
- *  @param env   - Current running environment
- */
-void exec_tins(uint_size_cmd from, uint_size_cmd ncmds, tcompo_env * env)
-{
-	const twrapper * wrapper = get_wrapper_from_env(env);
-	long * cintlsts = wrapper->consts.cints;
-	double * cdbllsts = wrapper->consts.cdbls;
-	char ** cstrlsts = wrapper->consts.cstrs;
-	uint_size_cmd idx = from;
-	uint_size_cmd end = from + ncmds;
-	tbycode * iter = wrapper->cmdarr + from;
-
-	while (idx < end) {
-		exec_tin(iter, idx, end, env, cintlsts, cdbllsts, cstrlsts);
-		idx++;
-		iter++;
-	}
+#undef Tap_BINOP_QUICK
+#undef Tap_CMPJPF
+#undef Tap_BINOP_Q
+#undef Tap_BINOP
+#undef Tap_NEXT
+#undef Tap_CASE
+#undef Tap_LOAD_WRAPPER
+#undef Tap_JUMP_TFUNC
+#undef Tap_GC_POINT
+#undef Tap_STK_LOAD
+#undef Tap_STK_SAVE
 }
 
 /** Eval bycodes of `lib` since `from` location
@@ -1349,9 +2106,15 @@ void exec_tins(uint_size_cmd from, uint_size_cmd ncmds, tcompo_env * env)
 void eval_bycodes(uint_size_cmd from, tlib * lib)
 {
 	twrapper * wrapper = lib->get_wrapper();
-	set_vmstack(lib->get_vmstack(), wrapper->info.reg_max);
+	set_tmpmax(wrapper->info.tmp_max);
+
+	if (__tmpmax + wrapper->info.reg_max > VMSTACK_SIZE_LIMIT)
+		twarn(ErrRuntime_StackOverflow).warn("tvm::eval_bycodes", "");
+	__stk = __vstk + __tmpmax;
+	__stklen = 0;
 	exec_tins(from, wrapper->ncmds - from, lib);
-	set_vmstack(nullptr, 0);
+	vmstk_pop_clean_front_n(__stklen);
+	__gc->release();
 }
 
 };
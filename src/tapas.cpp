@@ -18,7 +18,7 @@ bool exec_cmd_seq(tsession & sess,
 		return false;
 	if (cmd == "binary()")
 	{
-		tanalyser analyser;
+		tanalyser analyser(sess.get_superins());
 		twrapper * wrapper = analyser.wrap(tcmds, consts, info);
 		analyser.display_wrapper(wrapper);
 		analyser.clean_wrapper(wrapper);
@@ -35,8 +35,9 @@ bool exec_cmd_seq(tsession & sess,
 	}
 
 	// Try to execute the compiled code block
+	// (not optimized: it is executed from `ncmd_old` of the whole bycodes)
 	tconsts consts_cpy = consts.copy();
-	sess.get_lib()->set_wrapper(tanalyser().wrap(tcmds, consts_cpy, info));
+	sess.get_lib()->set_wrapper(tanalyser(sess.get_superins()).wrap(tcmds, consts_cpy, info));
 	vm.set_tmpmax(info.tmp_max);
 	try{
 		vm.eval_bycodes(ncmd_old, sess.get_lib());
@@ -53,7 +54,8 @@ void exec_interact(tsession & sess, const std::string & p_i1)
 	 || (p_i1[0] == '"'  && p_i1[p_i1.length() - 1] == '"'))
 		cmds = utils::trim(p_i1.substr(1, p_i1.length() - 2));
 	printf("Result:\n");
-	sess.execute_str(cmds);
+	if (!sess.execute_str(cmds))
+		exit(-1);
 }
 
 void cope_with_stdin(tsession & sess)
@@ -64,6 +66,9 @@ void cope_with_stdin(tsession & sess)
 	printf("      `binary()` for printing out binary codes, and\n");
 	printf("      `sys::__ls__()` for displaying all preloads.\n\n");
 
+	// Values made in the session, by the VM below too
+	tsession::tscope scope(sess);
+
 	// Tap lexer
 	tunit_ctr uint_ctr;
 	uint_ctr.restore_lex_ctrs();
@@ -145,34 +150,43 @@ void cope_with_1_input(tsession & sess, std::string p)
 		printf("  -ce               combination of -c and -e\n");
 		printf("  -cr               combination of -c and -r\n");
 		printf("\n");
+		printf("OPTION combined with others:\n");
+		printf("  -S                compile without superinstructions, e.g. tap -S -cr FILE\n");
+		printf("  -O0, -O1, -O2     level of static optimization (default -O2), e.g. tap -O0 -cr FILE\n");
+		printf("\n");
 		printf("OPTION with CMD followed:\n");
 		printf("  -i                execute the CMD\n");
 		printf("\n");
 		printf("Report bugs\n");
 		printf("Contact: <zhuanglinsheng@outlook.com>\n");
-	} else
-		sess.execute_file(p);
+	} else if (!sess.execute_file(p))
+		exit(-1);
 }
 
 void cope_with_2_params(tsession & sess, const std::string & p_i0, const std::string & p_i1)
 {
+	bool done = true;
+
 	if (p_i0 == "-c")
-		sess.compile_file(p_i1);
+		done = sess.compile_file(p_i1);
 	else if (p_i0 == "-e")
-		sess.eval_bycodes(p_i1);
+		done = sess.eval_bycodes(p_i1);
 	else if (p_i0 == "-r")
-		sess.show_bycodes(p_i1);
+		done = sess.show_bycodes(p_i1);
 	else if (p_i0 == "-p")
 		sess.add_path(p_i1);
+	else if (p_i0 == "-S")
+		sess.set_superins(false);
+	else if (p_i0 == "-O0" || p_i0 == "-O1" || p_i0 == "-O2")
+		sess.set_optlevel(static_cast<uint8_t>(p_i0[2] - '0'));
 	else if (p_i0 == "-i")
 		exec_interact(sess, p_i1);
-	else if (p_i0 == "-ce") {
-		sess.compile_file(p_i1);
-		sess.eval_bycodes(p_i1);
-	} else if (p_i0 == "-cr") {
-		sess.compile_file(p_i1);
-		sess.show_bycodes(p_i1);
-	}
+	else if (p_i0 == "-ce")
+		done = sess.compile_file(p_i1) && sess.eval_bycodes(p_i1);
+	else if (p_i0 == "-cr")
+		done = sess.compile_file(p_i1) && sess.show_bycodes(p_i1);
+	if (!done)
+		exit(-1);
 }
 
 int main(int argc, char **argv)
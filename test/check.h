@@ -0,0 +1,25 @@
+// file `check.h`: checks of the tests, and their main counting the failures
+#include "Tapas/tapas.h"
+#include <cstdio>
+
+using namespace tapas;
+
+static int nfails = 0;
+
+/// Run the checks of the test
+static void run();
+
+/// Count a failure unless `cond`, printing `what` failed
+static void check(bool cond, const char * what)
+{
+	if (cond)
+		return;
+	printf("FAIL: %s\n", what);
+	nfails++;
+}
+
+int main()
+{
+	run();
+	return nfails;
+}
@@ -0,0 +1,94 @@
+// file `closures.cpp`: the functions created in the activations of a recursive
+// function read the locals of their own activation, and are freed with it
+#include "check.h"
+
+// a function returned from a nested activation
+static const char * returned =
+	"let h = (n) {\n"
+	"	var x = n * 10\n"
+	"	var g = () {\n"
+	"		return x\n"
+	"	}\n"
+	"	if (n > 0) {\n"
+	"		g = this(n - 1)\n"
+	"		if (g() != 0) { [][1] }\n"
+	"		if (x != n * 10) { [][1] }\n"
+	"	}\n"
+	"	return g\n"
+	"}\n"
+	"let g = h(3)\n"
+	"if (g() != 0) { [][1] }\n";
+
+// a function of each activation, kept in a list
+static const char * kept =
+	"let k = (n, fs) {\n"
+	"	var y = n\n"
+	"	let c = () {\n"
+	"		return y\n"
+	"	}\n"
+	"	fs.std::append(c)\n"
+	"	if (n > 0) {\n"
+	"		let t = this(n - 1, fs)\n"
+	"	}\n"
+	"	return y\n"
+	"}\n"
+	"let fs = []\n"
+	"if (k(3, fs) != 3) { [][1] }\n"
+	"var n = 3\n"
+	"for (let c in fs) {\n"
+	"	if (c() != n) { [][1] }\n"
+	"	n = n - 1\n"
+	"}\n";
+
+// a function of the outer activation called in a nested one
+static const char * outer =
+	"let k = (n, c) {\n"
+	"	var y = n\n"
+	"	var r = 0\n"
+	"	if (n > 0) {\n"
+	"		let d = () {\n"
+	"			return y\n"
+	"		}\n"
+	"		r = this(n - 1, d)\n"
+	"	}\n"
+	"	if (n == 0) {\n"
+	"		r = c()\n"
+	"	}\n"
+	"	return r\n"
+	"}\n"
+	"if (k(1, 0) != 1) { [][1] }\n";
+
+// a function of each activation of a tail call
+static const char * tail =
+	"let t = (n, fs) {\n"
+	"	let c = () {\n"
+	"		return n\n"
+	"	}\n"
+	"	if (n == 0) {\n"
+	"		return fs\n"
+	"	}\n"
+	"	fs.std::append(c)\n"
+	"	return this(n - 1, fs)\n"
+	"}\n"
+	"var n = 3\n"
+	"for (let c in t(3, [])) {\n"
+	"	if (c() != n) { [][1] }\n"
+	"	n = n - 1\n"
+	"}\n";
+
+static void run()
+{
+	tsession sess;
+
+	sess.set_gc_threshold(0);
+	sess.execute_str("sys::__gc__()\n", false);
+
+	uint64_t bytes = sess.memory_stats().bytes;
+
+	check(sess.execute_str(returned, false), "function returned from a nested activation");
+	check(sess.execute_str(kept, false), "functions kept from the activations");
+	check(sess.execute_str(outer, false), "function of the outer activation");
+	check(sess.execute_str(tail, false), "functions of a tail call");
+	check(sess.execute_str("sys::__gc__()\n", false), "functions not collected");
+	check(sess.memory_stats().bytes == bytes, "activations left");
+}
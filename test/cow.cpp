@@ -0,0 +1,68 @@
+// file `cow.cpp`: copies of lists, dicts and strings share their storage until
+// either of them is changed, and are changed independently then
+#include "check.h"
+
+// a wrong value raises an error (index out of range)
+static const char * changes =
+	"let a = [1, 'two', [3]]\n"
+	"let b = a.std::copy()\n"
+	"b[0] = 5\n"
+	"b.std::append(4)\n"
+	"if (a[0] != 1 or a.std::len() != 3 or b[0] != 5 or b.std::len() != 4) { [][1] }\n"
+	"let c = b.std::copy()\n"
+	"c.std::pop()\n"
+	"c.std::delete(0)\n"
+	"c.std::insert(7, 0)\n"
+	"if (b[0] != 5 or b.std::len() != 4 or c[0] != 7 or c.std::len() != 3) { [][1] }\n"
+	"let i = [1, 2, 3, 4]\n"
+	"let j = i.std::copy()\n"
+	"j[0:4] = j\n"
+	"j[0:2] = [8, 9]\n"
+	"if (i[0] != 1 or i[1] != 2 or j[0] != 8 or j[2] != 3) { [][1] }\n"
+	"let d = {'k' : 1, 'l' : a}\n"
+	"let e = d.std::copy()\n"
+	"e['k'] = 2\n"
+	"let f = e.std::copy()\n"
+	"f.std::delete('l')\n"
+	"if (d['k'] != 1 or e['k'] != 2 or f['k'] != 2 or e.std::len() != 2 or f.std::len() != 1) { [][1] }\n"
+	"let m = {'k' : 0}\n"
+	"for (let k in 0 to 3) {\n"
+	"	let n = m.std::copy()\n"
+	"	m['k'] = k + 1\n"
+	"	if (m['k'] != k + 1 or n['k'] != k or m::k != k + 1) { [][1] }\n"
+	"}\n"
+	"let s = 'a string longer than sixteen chars'\n"
+	"let t = s.std::copy()\n"
+	"t.std::append('!')\n"
+	"let u = t.std::copy()\n"
+	"u[0] = 'A'\n"
+	"if (s.std::len() != 34 or t[34] != '!' or t[0] != 'a' or u[0] != 'A') { [][1] }\n";
+
+// copies of a dict of 1000 keys, kept until the end of the script
+static const char * copies =
+	"let d = {}\n"
+	"for (let i in 0 to 1000) {\n"
+	"	d[std::tostr(i)] = i\n"
+	"}\n"
+	"let l = []\n"
+	"for (let i in 0 to 1000) {\n"
+	"	l.std::append(d.std::copy())\n"
+	"}\n"
+	"let last = l[999]\n"
+	"last['0'] = 1\n";
+
+static void run()
+{
+	tsession sess;
+
+	check(sess.execute_str(changes, false), "copies not changed independently");
+	sess.execute_str("sys::__gc__()\n", false);
+
+	uint64_t bytes = sess.memory_stats().bytes;
+
+	sess.set_memory_limit(bytes + 1000 * 1024);
+	check(sess.execute_str(copies, false), "copies not sharing their tables");
+	sess.set_memory_limit(0);
+	sess.execute_str("sys::__gc__()\n", false);
+	check(sess.memory_stats().bytes == bytes, "copies or their tables left");
+}
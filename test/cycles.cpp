@@ -0,0 +1,34 @@
+// file `cycles.cpp`: cycles of lists, dicts and functions dropped by a script
+// are freed by the cycle collector, with the storage of their values
+#include "check.h"
+
+// 100 times, 4 values in cycles: two lists enclosing each other, a dict
+// stored in itself and referring to them, a function given itself as a
+// parameter
+static const char * cycles =
+	"for (let i in 0 to 100) {\n"
+	"	let l = ['a string longer than sixteen chars']\n"
+	"	let m = [l]\n"
+	"	l.std::append(m)\n"
+	"	let d = {'l' : l}\n"
+	"	d['d'] = d\n"
+	"	let f = (x) { var y = x }\n"
+	"	f(f)\n"
+	"}\n";
+
+static void run()
+{
+	tsession sess;
+
+	sess.set_gc_threshold(0);
+	sess.execute_str("sys::__gc__()\n", false);
+
+	uint64_t bytes = sess.memory_stats().bytes;
+	uint64_t nfreed = sess.get_gc_stats().nfreed;
+
+	check(sess.execute_str(cycles, false), "cycles not made");
+	check(sess.memory_stats().bytes > bytes, "cycles freed by reference counting");
+	check(sess.execute_str("sys::__gc__()\n", false), "cycles not collected");
+	check(sess.get_gc_stats().nfreed - nfreed == 100 * 4, "not all the values of the cycles freed");
+	check(sess.memory_stats().bytes == bytes, "values of the cycles left");
+}
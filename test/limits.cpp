@@ -0,0 +1,59 @@
+// file `limits.cpp`: the parameters of bycodes hold their limits (see Limit_U),
+// and those of narrow bycodes are moved on rewriting, if they fit; the
+// integers of the values hold their range
+#include "check.h"
+
+static void run()
+{
+	tbycode u(OP_JPF, Limit_U);
+	tbycode lr(OP_POPCOV, Limit_LR, Limit_LR);
+	tbycode cp(OP_VCRT, Limit_C, Limit_P);
+	tbycode lbi(OP_IDXL, Limit_LR, Limit_P, static_cast<uint8_t>(31));
+	tbycode lrk(OP_ADD, Limit_LRk, Limit_LRk, BINOP_TE);
+
+	check(u.ins() == OP_JPF && u.get_U() == Limit_U, "U of 26 bits");
+	check(lr.ins() == OP_POPCOV && lr.get_L() == Limit_LR && lr.get_R() == Limit_LR, "LR of 13 bits");
+	check(cp.ins() == OP_VCRT && cp.get_C() == Limit_C && cp.get_P() == Limit_P, "CP of 18 bits");
+	check(lbi.ins() == OP_IDXL && lbi.get_L() == Limit_LR && lbi.get_b() == Limit_P
+		&& lbi.get_i() == 31, "Lbi of 13 bits");
+	check(lrk.ins() == OP_ADD && lrk.get_Lk() == Limit_LRk && lrk.get_Rk() == Limit_LRk
+		&& lrk.get_k() == BINOP_TE, "LRk of 11 bits");
+
+	for (uint8_t ins = 0; ins < OP_NINS; ins++) {
+		tbycode cmd(ins, static_cast<uint32_t>(0));
+		check(cmd.ins() == ins && tbycode::ins_of(cmd.code()) == ins, "instruction not decoded");
+	}
+
+	// narrow bycodes: the parameters moved on rewriting, if they fit
+	check(!lrk.set_ins(OP_ADD_II) && lrk.ins() == OP_ADD, "LRk beyond narrow rewritten");
+	tbycode add(OP_ADD, Limit_LRk_N, Limit_LRk_N, BINOP_EE);
+	check(add.set_ins(OP_ADD_DD) && add.ins() == OP_ADD_DD && add.get_Lk_n() == Limit_LRk_N
+		&& add.get_Rk_n() == Limit_LRk_N && add.get_k() == BINOP_EE, "narrow LRk");
+	check(add.set_ins(OP_ADD) && add.get_Lk() == Limit_LRk_N && add.get_k() == BINOP_EE, "LRk back");
+	tbycode pushi(OP_PUSHI, Limit_C);
+	check(pushi.set_ins(OP_INCR) && pushi.ins() == OP_INCR && pushi.get_U_n() == Limit_C, "narrow U");
+	check(!u.set_ins(OP_PUSHK) && u.ins() == OP_JPF, "U beyond narrow rewritten");
+
+	// integers at the bounds of 48 bits, and past them: 64-bit, or an error
+	// with Tap_NAN_BOXING (not wrapped)
+	const long max48 = (1L << 47) - 1, min48 = -(1L << 47);
+	tsession sess;
+
+	check(tobj(max48).get_v_tint() == max48 && tobj(min48).get_v_tint() == min48, "48-bit integer");
+	check(sess.execute_str("var a = 140737488355327\nvar b = -140737488355328\n"
+		"if (a - 1 != 140737488355326) { [][1] }\nif (b + 1 != -140737488355327) { [][1] }\n", false),
+		"48-bit integer literals");
+#ifdef Tap_NAN_BOXING
+	bool boxed = true;
+
+	try { tobj(max48 + 1); } catch (...) { boxed = false; }
+	check(!boxed, "integer beyond 48 bits boxed");
+	check(!sess.execute_str("var a = 140737488355327\na = a + 1\n", false), "integer beyond 48 bits wrapped");
+	check(!sess.execute_str("var b = -140737488355328\nb = b - 1\n", false), "integer below 48 bits wrapped");
+	check(!sess.execute_str("var a = 281474976710656\n", false), "integer literal beyond 48 bits wrapped");
+#else
+	check(tobj(max48 + 1).get_v_tint() == max48 + 1, "integer beyond 48 bits");
+	check(sess.execute_str("var a = 140737488355327\na = a + 1\n"
+		"if (a != 140737488355328) { [][1] }\n", false), "integer beyond 48 bits not held");
+#endif
+}
@@ -0,0 +1,40 @@
+// file `memlimit.cpp`: a script beyond the memory limit of its session fails,
+// and the session runs the next ones
+#include "check.h"
+
+static const char * script =
+	"let a = []\n"
+	"for (let i in 0 to 100000) {\n"
+	"	a.std::append(std::tostr(i))\n"
+	"}\n"
+	"std::print(a.std::len())\n";
+
+// a list of numbers, allocating no value but the list: only its elements grow
+static const char * numbers =
+	"let a = []\n"
+	"for (let i in 0 to 100000) {\n"
+	"	a.std::append(i)\n"
+	"}\n"
+	"std::print(a.std::len())\n";
+
+static void run()
+{
+	tsession sess;
+	uint64_t limit = sess.memory_stats().bytes + 200000;
+
+	sess.set_memory_limit(limit);
+	check(!sess.execute_str(script, false), "script beyond the limit run");
+	check(sess.memory_stats().bytes <= limit, "bytes in use beyond the limit");
+	check(sess.execute_str("std::print([1, 2, 3].std::len())\n", false), "session not usable after the error");
+	sess.set_memory_limit(0);
+	check(sess.execute_str(script, false), "script not run without limit");
+	check(sess.memory_stats().bytes < limit, "values of the script left");
+
+	// the elements of the list accounted: 100000 numbers beyond the limit
+	sess.set_memory_limit(limit);
+	check(!sess.execute_str(numbers, false), "list of numbers beyond the limit run");
+	check(sess.memory_stats().bytes <= limit, "bytes in use beyond the limit by a list");
+	sess.set_memory_limit(0);
+	check(sess.execute_str(numbers, false), "list of numbers not run without limit");
+	check(sess.memory_stats().bytes < limit, "elements of the list left");
+}
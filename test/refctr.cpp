@@ -0,0 +1,87 @@
+// file `refctr.cpp`: counting the references of the values
+#include "check.h"
+#ifdef Tap_ATOMIC_REFCTR
+#include <thread>
+#include <vector>
+#endif
+
+static void run()
+{
+	tsession sess;
+	tsession::tscope scope(sess);
+
+	// a string referred by a holder, and more times than a 16-bit counter
+	// holds by others (e.g. the elements of a large list): it survives them
+	// dropped, then is freed with the holder
+	uint64_t bytes = sess.memory_stats().bytes;
+	tstr * big = new tstr("a string longer than sixteen chars");
+	const uint32_t nrefs = 70000;
+
+	big->add_refctr();
+	for (uint32_t i = 0; i < nrefs; i++)
+		big->add_refctr();
+	check(big->get_refctr() == nrefs + 1, "references beyond 16 bits not counted");
+	bool survives = true;
+	for (uint32_t i = 0; i < nrefs; i++)
+		survives = big->ddc_refctr() != 0 && survives;
+	check(survives && big->chars() == "a string longer than sixteen chars", "string referred freed");
+	check(sess.memory_stats().bytes > bytes, "string referred not accounted");
+	if (big->ddc_refctr() == 0)
+		big->release();
+	check(sess.memory_stats().bytes == bytes, "string no longer referred not freed");
+
+#ifdef Tap_ATOMIC_REFCTR
+	// a string held by a temporary object (of a thread), and referred by a
+	// value (of another thread) dropping it, then releasing its deferred
+	// values at a safe point
+	tstr * str = new tstr("held");
+
+	str->add_refctr();
+	str->gc_hold();
+	if (str->ddc_refctr() == 0)
+		str->release();
+	tgc::get_current()->release();
+	check(str->chars() == "held", "string held freed");
+	str->drop_held();
+	tgc::get_current()->release();
+
+	// a long string copied and hashed by sessions on other threads at once:
+	// it is only read, and its copies are its characters
+	tstr * text = new tstr("a string long enough to share its characters with copies");
+	const std::string chars = text->chars();
+	const std::size_t hash = text->hash();
+	std::vector<std::thread> threads;
+	std::vector<char> same(8, 0);
+
+	text->add_refctr();
+	for (std::size_t t = 0; t < same.size(); t++)
+		threads.emplace_back([text, &chars, hash, &same, t]() {
+			tsession sess;
+			tsession::tscope scope(sess);
+			tobj mark = 1L;
+			bool ok = true;
+
+			for (int i = 0; i < 10000; i++) {
+				tstr * copy = text->copy();
+
+				copy->add_refctr();
+				text->add_refctr();
+				ok = ok && copy->chars() == chars && copy->hash() == hash && text->hash() == hash;
+				copy->set_append(&mark);
+				ok = ok && text->chars() == chars;
+				if (copy->ddc_refctr() == 0)
+					copy->release();
+				if (text->ddc_refctr() == 0)
+					text->release();
+			}
+			same[t] = ok;
+		});
+	for (std::thread & thread : threads)
+		thread.join();
+	for (char ok : same)
+		check(ok, "string copied by threads changed");
+	check(text->get_refctr() == 1 && text->chars() == chars, "string copied by threads not kept");
+	if (text->ddc_refctr() == 0)
+		text->release();
+#endif
+}
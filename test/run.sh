@@ -0,0 +1,34 @@
+#!/bin/bash
+# usage: test/run.sh [compiler flags] - build the tests and tap with ASan, and run them
+# (leaks detected too: a session frees the cycles left before its slab)
+cd "$(dirname "$0")/.."
+CXX=${CXX:-clang++}
+BIN=${TMPDIR:-/tmp}
+fail=0
+
+for t in sessions memlimit refctr cow cycles limits closures; do
+	$CXX ./test/$t.cpp -std=c++11 -I./include -fsanitize=address -O0 -pthread "$@" -o $BIN/tap_$t || exit 1
+	$BIN/tap_$t > $BIN/tap_$t.out 2>&1 || { echo "FAIL $t"; cat $BIN/tap_$t.out; fail=1; }
+done
+
+# the values shared by the threads of refctr are checked for races by TSan
+if [[ " $* " == *" -DTap_ATOMIC_REFCTR "* ]]; then
+	$CXX ./test/refctr.cpp -std=c++11 -I./include -fsanitize=thread -O1 -pthread "$@" -o $BIN/tap_refctr_tsan || exit 1
+	$BIN/tap_refctr_tsan > $BIN/tap_refctr_tsan.out 2>&1 || { echo "FAIL refctr (TSan)"; cat $BIN/tap_refctr_tsan.out; fail=1; }
+fi
+
+# the scripts of test/opt print the same at every level of optimization as
+# with none, nor superinstructions (their .tapc are written in $BIN)
+$CXX ./src/tapas.cpp -std=c++11 -I./include -fsanitize=address -O0 "$@" -o $BIN/tap_cli -lreadline || exit 1
+mkdir -p $BIN/tap_opt
+for s in ./test/opt/*.tap; do
+	t=$BIN/tap_opt/$(basename $s .tap)
+	cp $s $t.tap
+	$BIN/tap_cli -S -O0 -ce $t.tap > $t.out 2>&1 || { echo "FAIL $s"; cat $t.out; fail=1; continue; }
+	for o in -O0 -O1 -O2; do
+		$BIN/tap_cli $o -ce $t.tap > $t$o.out 2>&1 && cmp -s $t.out $t$o.out \
+			|| { echo "FAIL $s $o"; diff $t.out $t$o.out; fail=1; }
+	done
+done
+[ $fail == 0 ] && echo "all tests passed"
+exit $fail
@@ -0,0 +1,113 @@
+// file `sessions.cpp`: sessions made and destroyed in any order, each one
+// allocating, accounting and collecting its own values
+#include "check.h"
+
+static const char * script =
+	"let l = [1, 'one', [2]]\n"
+	"let d = {'l' : l}\n"
+	"d['d'] = d\n"
+	"var s = []\n"
+	"for (let i in 0 to 1000) {\n"
+	"	s.std::append(std::tostr(i))\n"
+	"}\n"
+	"std::print(s.std::len(), ' ', sys::__gc__() >= 0)\n";
+
+// cycles left alive at the end of the session, whose storage out of the slab
+// (elements, table, characters) leaks unless they are freed by the session
+static const char * cycles =
+	"let c = []\n"
+	"c.std::append(c)\n"
+	"for (let i in 0 to 1000) {\n"
+	"	c.std::append('a string longer than sixteen chars')\n"
+	"}\n"
+	"let d = {'c' : c}\n"
+	"d['d'] = d\n"
+	"let f = (x) { var y = x }\n"
+	"f(f)\n";
+
+static void run()
+{
+	// destroyed in the reverse order, the last made not being run
+	tsession * a = new tsession();
+	tsession * b = new tsession();
+	uint64_t bytes_b = b->memory_stats().bytes;
+
+	a->execute_str(script, false);
+	check(b->memory_stats().bytes == bytes_b, "values of a accounted by b");
+	check(a->memory_stats().bytes > 0, "values of a not accounted by a");
+	delete b;
+	a->execute_str(script, false);
+	delete a;
+
+	// destroyed in the order made
+	a = new tsession();
+	b = new tsession();
+	b->execute_str(script, false);
+	delete a;
+	b->execute_str(script, false);
+	delete b;
+
+	// a value freed in the scope of another session is discharged from its own
+	a = new tsession();
+	b = new tsession();
+	uint64_t bytes_a = a->memory_stats().bytes;
+	bytes_b = b->memory_stats().bytes;
+	tlist * list = nullptr;
+	{
+		tsession::tscope scope(*a);
+		list = new tlist();
+	}
+	check(a->memory_stats().bytes > bytes_a, "value not accounted by its session");
+	{
+		tsession::tscope scope(*b);
+		delete list;
+	}
+	check(a->memory_stats().bytes == bytes_a, "value not discharged from its session");
+	check(b->memory_stats().bytes == bytes_b, "value discharged from another session");
+	delete b;
+
+#ifdef Tap_NO_SLAB
+	// a value outliving its session
+	{
+		tsession::tscope scope(*a);
+		list = new tlist();
+	}
+	delete a;
+	delete list;
+#else
+	delete a;
+#endif
+
+	// ended with cycles alive
+	a = new tsession();
+	check(a->execute_str(cycles, false), "cycles not made");
+	check(a->get_gc_stats().nfreed == 0, "cycles alive freed");
+	delete a;
+
+	// values made by the program out of any session
+	tstr * str = new tstr("out of any session");
+
+	check(str->chars() == "out of any session", "value out of any session");
+	delete str;
+
+	// the types registered by the sessions: again by the same type, not by
+	// another one
+	bool again = true, other = true;
+
+	try { tcompo_register<tlist>(compo_tlist); } catch (...) { again = false; }
+	try { tcompo_register<tstr>(compo_tlist); } catch (...) { other = false; }
+	check(again, "type registered again");
+	check(!other, "code of a type registered by another type");
+
+	// bycodes whose OP_PUSHF is not preceded by its infos, which would make
+	// a prototype each time it is executed: refused at loading
+	tbycode cmds[] = { tbycode(OP_PUSHINFO, 0), tbycode(OP_PUSHF, 0) };
+	twrapper * wrapper = new twrapper();
+	bool loaded = true;
+
+	wrapper->cmdarr = cmds;
+	wrapper->ncmds = 2;
+	try { tanalyser().make_protos(wrapper); } catch (...) { loaded = false; }
+	check(!loaded && wrapper->protos == nullptr, "OP_PUSHF without its infos loaded");
+	delete wrapper;
+}